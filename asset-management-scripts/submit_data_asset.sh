@@ -1,5 +1,5 @@
 #!/bin/sh
-# argv[1] - path to the descriptor file
+# argv[1] - path to the descriptor file (YAML, see --export-handle)
 # argv[2] - path to schema file
 # argv[3] - comment
 # argv[4] - path to save the response (Blockchain Asset)
@@ -15,12 +15,13 @@ ASSET_HASH=`cat $MODEL_HASH_FILE`
 SOURCE_ASSET_UUID=`jq -r '.assetUUID' ${SOURCE_ASSET_FILE}`
 ZK_PROOF=`yq -r '.Proof' $PROOF_FILE`
 PERFORMANCE=`yq -r '.R2' $PROOF_FILE`
+MODEL_HASH_VERSION=`yq -r '.ModelHashVersion' $PROOF_FILE`
 
 # build the asset from the template
 jq --arg a "${ASSET_HASH}" --arg b "${SOURCE_ASSET_UUID}" \
      --arg c "${COMMENT}" --arg d "${PERFORMANCE}" \
-     --arg e "${ZK_PROOF}" \
-    ' .propertyHashes.assetHash=$a | .sourceAssets[0]=$b | .transformationInfo.description=$c | .transformationInfo.MetricR2=$d | .otherInfo[0]=$e' ../asset-templates/linear_model_asset_template.json > /tmp/linear_model_asset.json
+     --arg e "${ZK_PROOF}" --arg f "${MODEL_HASH_VERSION}" \
+    ' .propertyHashes.assetHash=$a | .propertyHashes.assetHashVersion=$f | .sourceAssets[0]=$b | .transformationInfo.description=$c | .transformationInfo.MetricR2=$d | .otherInfo[0]=$e' ../asset-templates/linear_model_asset_template.json > /tmp/linear_model_asset.json
 
 # submit the asset to blockchain
 curl -X POST "${IBP_ENDPOINT}" \
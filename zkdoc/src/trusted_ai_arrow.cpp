@@ -0,0 +1,260 @@
+#include <fstream>
+#include <iostream>
+#include <cstring>
+
+namespace TrustedAI {
+
+//! magic string at the start (and end) of an Arrow IPC file
+const char arrow_file_magic[6] = {'A', 'R', 'R', 'O', 'W', '1'};
+
+inline bool is_arrow_file(const std::string& file)
+{
+    std::ifstream in(file, std::ios::binary);
+    char magic[sizeof(arrow_file_magic)] = {0};
+    in.read(magic, sizeof(magic));
+    return in.good() && (std::memcmp(magic, arrow_file_magic, sizeof(magic)) == 0);
+}
+
+#ifdef WITH_ARROW
+
+inline bool arrow_dataset_reader::open(const std::string& file)
+{
+    auto mapped = arrow::io::MemoryMappedFile::Open(file, arrow::io::FileMode::READ);
+    if (!mapped.ok()) {
+        std::cout << "Unable to map " << file << ": " << mapped.status().ToString() << std::endl;
+        return false;
+    }
+    file_ = mapped.ValueOrDie();
+
+    auto opened = arrow::ipc::RecordBatchFileReader::Open(file_);
+    if (!opened.ok()) {
+        std::cout << "Not an Arrow IPC file " << file << ": " << opened.status().ToString() << std::endl;
+        return false;
+    }
+    auto reader = opened.ValueOrDie();
+
+    names_.clear();
+    for(auto& field : reader->schema()->fields())
+        names_.emplace_back(field->name());
+
+    batches_.clear();
+    num_rows_ = 0;
+    for(int i=0; i < reader->num_record_batches(); ++i) {
+        auto batch = reader->ReadRecordBatch(i);
+        if (!batch.ok()) {
+            std::cout << "Unable to read record batch " << i << " of " << file
+                << ": " << batch.status().ToString() << std::endl;
+            return false;
+        }
+        batches_.emplace_back(batch.ValueOrDie());
+        num_rows_ += batches_.back()->num_rows();
+    }
+    return true;
+}
+
+/**
+ * Reports the first null of a column, if any
+ * @input row0 index of the first row of the batch
+ */
+inline bool arrow_check_no_nulls(
+    const arrow::Array& array,
+    const std::string& name,
+    size_t row0)
+{
+    if (array.null_count() == 0) return true;
+    for(int64_t i=0; i < array.length(); ++i) {
+        if (array.IsNull(i)) {
+            std::cout << "Row " << row0 + i + 1 << ", column " << name << ": null value" << std::endl;
+            break;
+        }
+    }
+    return false;
+}
+
+/**
+ * Appends the values of a numeric array with a per-element
+ * conversion, optionally rejecting negative values
+ */
+template<typename ArrayT, typename OutT>
+bool arrow_append_converted(
+    const arrow::Array& array,
+    std::vector<OutT>& values,
+    bool non_negative,
+    const std::string& name,
+    size_t row0)
+{
+    const auto& typed = static_cast<const ArrayT&>(array);
+    const auto* raw = typed.raw_values();
+    for(int64_t i=0; i < typed.length(); ++i) {
+        if (non_negative && raw[i] < 0) {
+            std::cout << "Row " << row0 + i + 1 << ", column " << name
+                << ": negative integer " << raw[i] << std::endl;
+            return false;
+        }
+        values.emplace_back(OutT(raw[i]));
+    }
+    return true;
+}
+
+inline bool arrow_dataset_reader::read_integer_column(
+    size_t col,
+    std::vector<uint64_t>& values) const
+{
+    values.clear();
+    values.reserve(num_rows_);
+    size_t row0 = 0;
+    for(auto& batch : batches_) {
+        const arrow::Array& array = *batch->column(col);
+        if (!arrow_check_no_nulls(array, names_[col], row0))
+            return false;
+
+        bool ok = true;
+        switch (array.type_id()) {
+            case arrow::Type::UINT64: {
+                // same layout, copy the buffer as a whole
+                const auto& typed = static_cast<const arrow::UInt64Array&>(array);
+                values.insert(values.end(), typed.raw_values(), typed.raw_values() + typed.length());
+                break;
+            }
+            case arrow::Type::UINT8:
+                ok = arrow_append_converted<arrow::UInt8Array>(array, values, false, names_[col], row0);
+                break;
+            case arrow::Type::UINT16:
+                ok = arrow_append_converted<arrow::UInt16Array>(array, values, false, names_[col], row0);
+                break;
+            case arrow::Type::UINT32:
+                ok = arrow_append_converted<arrow::UInt32Array>(array, values, false, names_[col], row0);
+                break;
+            case arrow::Type::INT8:
+                ok = arrow_append_converted<arrow::Int8Array>(array, values, true, names_[col], row0);
+                break;
+            case arrow::Type::INT16:
+                ok = arrow_append_converted<arrow::Int16Array>(array, values, true, names_[col], row0);
+                break;
+            case arrow::Type::INT32:
+                ok = arrow_append_converted<arrow::Int32Array>(array, values, true, names_[col], row0);
+                break;
+            case arrow::Type::INT64:
+                ok = arrow_append_converted<arrow::Int64Array>(array, values, true, names_[col], row0);
+                break;
+            default:
+                std::cout << "Column " << names_[col] << ": expected an integer type, found "
+                    << array.type()->ToString() << std::endl;
+                return false;
+        }
+        if (!ok) return false;
+        row0 += array.length();
+    }
+    return true;
+}
+
+inline bool arrow_dataset_reader::read_numeric_column(
+    size_t col,
+    std::vector<double>& values) const
+{
+    values.clear();
+    values.reserve(num_rows_);
+    size_t row0 = 0;
+    for(auto& batch : batches_) {
+        const arrow::Array& array = *batch->column(col);
+        if (!arrow_check_no_nulls(array, names_[col], row0))
+            return false;
+
+        bool ok = true;
+        switch (array.type_id()) {
+            case arrow::Type::DOUBLE: {
+                const auto& typed = static_cast<const arrow::DoubleArray&>(array);
+                values.insert(values.end(), typed.raw_values(), typed.raw_values() + typed.length());
+                break;
+            }
+            case arrow::Type::FLOAT:
+                ok = arrow_append_converted<arrow::FloatArray>(array, values, false, names_[col], row0);
+                break;
+            case arrow::Type::INT32:
+                ok = arrow_append_converted<arrow::Int32Array>(array, values, false, names_[col], row0);
+                break;
+            case arrow::Type::INT64:
+                ok = arrow_append_converted<arrow::Int64Array>(array, values, false, names_[col], row0);
+                break;
+            case arrow::Type::UINT64:
+                ok = arrow_append_converted<arrow::UInt64Array>(array, values, false, names_[col], row0);
+                break;
+            default:
+                std::cout << "Column " << names_[col] << ": expected a numeric type, found "
+                    << array.type()->ToString() << std::endl;
+                return false;
+        }
+        if (!ok) return false;
+        row0 += array.length();
+    }
+    return true;
+}
+
+/**
+ * Interns every value of a (large) string array
+ */
+template<typename ArrayT>
+void arrow_intern_strings(
+    const arrow::Array& array,
+    string_dictionary& dict,
+    std::vector<uint32_t>& codes)
+{
+    const auto& typed = static_cast<const ArrayT&>(array);
+    for(int64_t i=0; i < typed.length(); ++i) {
+        typename ArrayT::offset_type len;
+        const uint8_t* value = typed.GetValue(i, &len);
+        codes.emplace_back(dict.intern(reinterpret_cast<const char*>(value), len));
+    }
+}
+
+inline bool arrow_dataset_reader::read_categorical_column(
+    size_t col,
+    string_dictionary& dict,
+    std::vector<uint32_t>& codes) const
+{
+    codes.clear();
+    codes.reserve(num_rows_);
+    size_t row0 = 0;
+    for(auto& batch : batches_) {
+        const arrow::Array& array = *batch->column(col);
+        if (!arrow_check_no_nulls(array, names_[col], row0))
+            return false;
+
+        switch (array.type_id()) {
+            case arrow::Type::STRING:
+                arrow_intern_strings<arrow::StringArray>(array, dict, codes);
+                break;
+            case arrow::Type::LARGE_STRING:
+                arrow_intern_strings<arrow::LargeStringArray>(array, dict, codes);
+                break;
+            case arrow::Type::DICTIONARY: {
+                // intern the batch dictionary once, then map indices
+                const auto& typed = static_cast<const arrow::DictionaryArray&>(array);
+                const auto& values = *typed.dictionary();
+                std::vector<uint32_t> value_codes;
+                if (values.type_id() == arrow::Type::STRING)
+                    arrow_intern_strings<arrow::StringArray>(values, dict, value_codes);
+                else if (values.type_id() == arrow::Type::LARGE_STRING)
+                    arrow_intern_strings<arrow::LargeStringArray>(values, dict, value_codes);
+                else {
+                    std::cout << "Column " << names_[col] << ": expected string dictionary, found "
+                        << values.type()->ToString() << std::endl;
+                    return false;
+                }
+                for(int64_t i=0; i < typed.length(); ++i)
+                    codes.emplace_back(value_codes[typed.GetValueIndex(i)]);
+                break;
+            }
+            default:
+                std::cout << "Column " << names_[col] << ": expected a string type, found "
+                    << array.type()->ToString() << std::endl;
+                return false;
+        }
+        row0 += array.length();
+    }
+    return true;
+}
+
+#endif
+
+} // namespace
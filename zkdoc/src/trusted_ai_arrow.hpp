@@ -0,0 +1,66 @@
+#ifndef __TRUSTED_AI_ARROW_HPP__
+#define __TRUSTED_AI_ARROW_HPP__
+
+#include <zkdoc/src/trusted_ai_encoder.hpp>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#ifdef WITH_ARROW
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/reader.h>
+#endif
+
+namespace TrustedAI {
+
+/**
+ * Checks whether file is an Arrow IPC file (this includes
+ * Feather V2 files), by its leading magic
+ */
+inline bool is_arrow_file(const std::string& file);
+
+#ifdef WITH_ARROW
+/**
+ * Reader for tabular data in an Arrow IPC (Feather V2) file.
+ * The file is memory mapped, record batches reference the
+ * mapping directly, and columns are copied out batch by batch:
+ * uint64 and double buffers with a single bulk copy, other
+ * numeric types with a per-element widening. Null values are
+ * rejected since the circuits have no representation for them.
+ */
+class arrow_dataset_reader {
+private:
+    std::shared_ptr<arrow::io::MemoryMappedFile> file_;
+    std::vector<std::shared_ptr<arrow::RecordBatch>> batches_;
+    std::vector<std::string> names_;
+    size_t num_rows_;
+
+public:
+    arrow_dataset_reader(): num_rows_(0) {};
+
+    // @return false if the file cannot be mapped or parsed
+    bool open(const std::string& file);
+
+    size_t num_rows() const { return num_rows_; };
+    size_t num_columns() const { return names_.size(); };
+    const std::string& column_name(size_t col) const { return names_[col]; };
+
+    // unsigned or non-negative signed integer column
+    bool read_integer_column(size_t col, std::vector<uint64_t>& values) const;
+    // floating point or integer column
+    bool read_numeric_column(size_t col, std::vector<double>& values) const;
+    // string or dictionary encoded string column
+    bool read_categorical_column(
+        size_t col,
+        string_dictionary& dict,
+        std::vector<uint32_t>& codes) const;
+};
+#endif
+
+} // namespace
+
+#include <zkdoc/src/trusted_ai_arrow.cpp>
+
+#endif
@@ -0,0 +1,115 @@
+#include <cstring>
+
+namespace TrustedAI {
+
+//! items are padded to this alignment
+const size_t binary_io_alignment = 8;
+
+inline size_t binary_io_padded(size_t len)
+{
+    return (len + binary_io_alignment - 1) / binary_io_alignment * binary_io_alignment;
+}
+
+inline void binary_writer::pad(size_t len)
+{
+    static const char zeros[binary_io_alignment] = {0};
+    out_.write(zeros, binary_io_padded(len) - len);
+}
+
+inline void binary_writer::write_magic(const char magic[8])
+{
+    out_.write(magic, 8);
+}
+
+inline void binary_writer::write_u64(uint64_t value)
+{
+    out_.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void binary_writer::write_string(const std::string& value)
+{
+    write_u64(value.size());
+    out_.write(value.data(), value.size());
+    pad(value.size());
+}
+
+template<typename T>
+void binary_writer::write_array(const T* values, size_t n)
+{
+    write_u64(n);
+    out_.write(reinterpret_cast<const char*>(values), n * sizeof(T));
+    pad(n * sizeof(T));
+}
+
+inline const char* binary_reader::take(size_t len)
+{
+    const size_t padded = binary_io_padded(len);
+    if (!ok_ || padded > size_t(end_ - pos_) || padded < len) {
+        ok_ = false;
+        return nullptr;
+    }
+    const char* p = pos_;
+    pos_ += padded;
+    return p;
+}
+
+inline bool binary_reader::check_magic(const char magic[8])
+{
+    const char* p = take(8);
+    ok_ = (p != nullptr) && (std::memcmp(p, magic, 8) == 0);
+    return ok_;
+}
+
+inline uint64_t binary_reader::read_u64()
+{
+    uint64_t value = 0;
+    const char* p = take(sizeof(value));
+    if (p != nullptr)
+        std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint64_t binary_reader::read_count(size_t min_size)
+{
+    const uint64_t n = read_u64();
+    if (n > size_t(end_ - pos_) / min_size) {
+        ok_ = false;
+        return 0;
+    }
+    return n;
+}
+
+inline std::string binary_reader::read_string()
+{
+    const uint64_t len = read_u64();
+    if (len > size_t(end_ - pos_)) {
+        ok_ = false;
+        return std::string();
+    }
+    const char* p = take(len);
+    return (p == nullptr) ? std::string() : std::string(p, len);
+}
+
+template<typename T>
+const T* binary_reader::view_array(size_t& n)
+{
+    n = read_u64();
+    if (n > size_t(end_ - pos_) / sizeof(T)) {
+        ok_ = false;
+        n = 0;
+        return nullptr;
+    }
+    const char* p = take(n * sizeof(T));
+    if (p == nullptr) n = 0;
+    return reinterpret_cast<const T*>(p);
+}
+
+template<typename T>
+void binary_reader::read_array(std::vector<T>& values)
+{
+    size_t n;
+    const T* p = view_array<T>(n);
+    values.assign(p, p + n);
+}
+
+} // namespace
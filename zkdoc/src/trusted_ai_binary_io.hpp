@@ -0,0 +1,79 @@
+#ifndef __TRUSTED_AI_BINARY_IO_HPP__
+#define __TRUSTED_AI_BINARY_IO_HPP__
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace TrustedAI {
+
+/**
+ * Writer for the binary files of this tool (dataset caches,
+ * data handles). Values are written in native byte order, and
+ * every item is padded to a multiple of 8 bytes, so that arrays
+ * in a memory mapped file are suitably aligned for direct use.
+ */
+class binary_writer {
+private:
+    std::ostream& out_;
+
+public:
+    binary_writer(std::ostream& out): out_(out) {};
+
+    void write_magic(const char magic[8]);
+    void write_u64(uint64_t value);
+    void write_string(const std::string& value);
+    // element count followed by the raw elements
+    template<typename T>
+    void write_array(const T* values, size_t n);
+    template<typename T>
+    void write_array(const std::vector<T>& values) { write_array(values.data(), values.size()); };
+
+    bool good() const { return out_.good(); };
+
+private:
+    void pad(size_t len);
+};
+
+/**
+ * Reader over a memory region written by binary_writer.
+ * Reads past the end of the region set the failure flag and
+ * return empty values, so that a file can be parsed first and
+ * checked once with ok().
+ */
+class binary_reader {
+private:
+    const char* pos_;
+    const char* end_;
+    bool ok_;
+
+public:
+    binary_reader(const char* begin, const char* end):
+        pos_(begin), end_(end), ok_(true) {};
+
+    bool check_magic(const char magic[8]);
+    uint64_t read_u64();
+    // count of items of at least min_size bytes each, failing if
+    // the rest of the region cannot hold them
+    uint64_t read_count(size_t min_size);
+    std::string read_string();
+    // pointer to n elements inside the region, no copy
+    template<typename T>
+    const T* view_array(size_t& n);
+    template<typename T>
+    void read_array(std::vector<T>& values);
+
+    bool ok() const { return ok_; };
+    bool at_end() const { return pos_ == end_; };
+
+private:
+    const char* take(size_t len);
+};
+
+} // namespace
+
+#include <zkdoc/src/trusted_ai_binary_io.cpp>
+
+#endif
@@ -0,0 +1,232 @@
+#include <openssl/evp.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <cctype>
+
+namespace TrustedAI {
+
+inline std::string sha256_hex(const char* data, size_t size)
+{
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    if (!EVP_Digest(data, size, digest, &len, EVP_sha256(), nullptr))
+        return "";
+
+    static const char hex[] = "0123456789abcdef";
+    std::string out;
+    for(unsigned int i=0; i < len; ++i) {
+        out += hex[digest[i] >> 4];
+        out += hex[digest[i] & 0xf];
+    }
+    return out;
+}
+
+inline std::string sha256_file(const std::string& file)
+{
+    mapped_file mfile;
+    if (!mfile.open(file))
+        return "";
+    return sha256_hex(mfile.data(), mfile.size());
+}
+
+inline std::string fast_hash_hex(const char* data, size_t size)
+{
+    // 64-bit words through a multiply-rotate mix, then a final
+    // avalanche so that every input bit reaches every output bit
+    const uint64_t k1 = 0x87c37b91114253d5ULL, k2 = 0x4cf5ad432745937fULL;
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ size;
+    size_t i = 0;
+    for(; i + 8 <= size; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, data + i, 8);
+        w *= k1;
+        h ^= (w << 31) | (w >> 33);
+        h = ((h << 27) | (h >> 37)) * k2;
+    }
+    for(; i < size; ++i)
+        h = (h ^ uint8_t(data[i])) * k1;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)h);
+    return hex;
+}
+
+inline std::string fast_hash_file(const std::string& file)
+{
+    mapped_file mfile;
+    if (!mfile.open(file))
+        return "";
+    return fast_hash_hex(mfile.data(), mfile.size());
+}
+
+inline std::string cache_key(const std::vector<std::string>& parts)
+{
+    std::string joined;
+    for(auto& part : parts)
+        joined += std::to_string(part.size()) + ":" + part;
+    return sha256_hex(joined);
+}
+
+inline bool read_file_bytes(const std::string& file, std::string& value)
+{
+    std::ifstream in(file, std::ios::binary);
+    if (!in)
+        return false;
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    value = buffer.str();
+    return !in.bad();
+}
+
+inline bool write_file_bytes(const std::string& file, const std::string& value)
+{
+    std::ofstream out(file, std::ios::binary);
+    out.write(value.data(), value.size());
+    out.close();
+    return !out.fail();
+}
+
+inline std::string fingerprint_index::find(
+    const std::string& fast,
+    const std::function<std::string()>& sha256) const
+{
+    std::ifstream in(file_);
+    std::string line_fast, line_sha, result, digest;
+    while (in >> line_fast >> line_sha && std::getline(in >> std::ws, result)) {
+        if (line_fast != fast)
+            continue;
+        if (digest.empty())
+            digest = sha256();
+        if (digest.empty() || line_sha != digest)
+            continue;
+
+        // the sidecar must still describe the result
+        std::ifstream sidecar(result + ".fp");
+        std::string fp_fast, fp_sha, result_sha;
+        if (sidecar >> fp_fast >> fp_sha >> result_sha &&
+            fp_fast == fast && fp_sha == digest && sha256_file(result) == result_sha)
+            return result;
+    }
+    return "";
+}
+
+inline bool fingerprint_index::add(const fingerprint& fp, const std::string& file) const
+{
+    const std::string result_sha = sha256_file(file);
+    if (result_sha.empty() ||
+        !write_file_bytes(file + ".fp", fp.fast + " " + fp.sha256 + " " + result_sha + "\n"))
+        return false;
+
+    // results are indexed by absolute path, runs may start anywhere
+    char path[PATH_MAX];
+    if (realpath(file.c_str(), path) == nullptr)
+        return false;
+    const std::string result_file = path;
+
+    // replace the entry of result_file, keep the others
+    std::string entries, line;
+    std::ifstream in(file_);
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string line_fast, line_sha, result;
+        if (fields >> line_fast >> line_sha && std::getline(fields >> std::ws, result) && result != result_file)
+            entries += line + "\n";
+    }
+    in.close();
+    entries += fp.fast + " " + fp.sha256 + " " + result_file + "\n";
+
+    const std::string tmp = file_ + ".tmp." + std::to_string(getpid());
+    if (!write_file_bytes(tmp, entries) || std::rename(tmp.c_str(), file_.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+inline std::string content_cache::path(const std::string& key) const
+{
+    return dir_ + "/" + key.substr(0, 2) + "/" + key;
+}
+
+inline bool content_cache::get(const std::string& key, std::string& value) const
+{
+    if (!read_file_bytes(path(key), value))
+        return false;
+    // the modification time orders the entries for eviction
+    utimes(path(key).c_str(), nullptr);
+    return true;
+}
+
+inline bool content_cache::put(const std::string& key, const std::string& value) const
+{
+    mkdir(dir_.c_str(), 0755);
+    mkdir((dir_ + "/" + key.substr(0, 2)).c_str(), 0755);
+    const std::string tmp = path(key) + ".tmp." + std::to_string(getpid());
+    if (!write_file_bytes(tmp, value) || std::rename(tmp.c_str(), path(key).c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    evict();
+    return true;
+}
+
+inline uint64_t content_cache::evict() const
+{
+    struct entry {
+        std::string file;
+        time_t used;
+        uint64_t size;
+    };
+    std::vector<entry> entries;
+    uint64_t total = 0;
+
+    DIR* top = opendir(dir_.c_str());
+    if (top == nullptr)
+        return 0;
+    while (struct dirent* sub = readdir(top)) {
+        // only the two hex digit directories of put, not ..
+        const std::string prefix = sub->d_name;
+        if (prefix.size() != 2 || !std::isxdigit(prefix[0]) || !std::isxdigit(prefix[1]))
+            continue;
+        const std::string subdir = dir_ + "/" + sub->d_name;
+        DIR* d = opendir(subdir.c_str());
+        if (d == nullptr)
+            continue;
+        while (struct dirent* e = readdir(d)) {
+            const std::string name = e->d_name;
+            struct stat st;
+            // entries are named by their key, skip ., .. and the
+            // temporary files of other runs
+            if (name.size() != 64 || name.compare(0, 2, prefix) != 0)
+                continue;
+            if (stat((subdir + "/" + name).c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+                continue;
+            entries.push_back({subdir + "/" + name, st.st_mtime, uint64_t(st.st_size)});
+            total += st.st_size;
+        }
+        closedir(d);
+    }
+    closedir(top);
+
+    std::sort(entries.begin(), entries.end(),
+        [](const entry& a, const entry& b) { return a.used < b.used; });
+    for(size_t i=0; i < entries.size() && total > max_bytes_; ++i) {
+        if (std::remove(entries[i].file.c_str()) == 0)
+            total -= entries[i].size;
+    }
+    return total;
+}
+
+} // namespace
@@ -0,0 +1,125 @@
+#ifndef __TRUSTED_AI_CACHE_HPP__
+#define __TRUSTED_AI_CACHE_HPP__
+
+#include <zkdoc/src/trusted_ai_csv.hpp>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+namespace TrustedAI {
+
+/**
+ * SHA-256 of data (OpenSSL libcrypto), as lowercase hex
+ */
+inline std::string sha256_hex(const char* data, size_t size);
+inline std::string sha256_hex(const std::string& data)
+{ return sha256_hex(data.data(), data.size()); }
+
+/**
+ * SHA-256 of the contents of a file
+ * @return "" if the file cannot be read
+ */
+inline std::string sha256_file(const std::string& file);
+
+/**
+ * Fast non-cryptographic 64-bit hash of data, as hex. It only
+ * screens for identical inputs, matches are confirmed by SHA-256.
+ */
+inline std::string fast_hash_hex(const char* data, size_t size);
+
+/**
+ * Fast hash of the contents of a file
+ * @return "" if the file cannot be read
+ */
+inline std::string fast_hash_file(const std::string& file);
+
+/**
+ * Key of a cache entry from the parts it depends on (a kind, such
+ * as "performance-proof", then digests and parameters). The parts
+ * are length prefixed, so that no two lists give the same key.
+ */
+inline std::string cache_key(const std::vector<std::string>& parts);
+
+/**
+ * Local content-addressed cache of the results of the tool. An
+ * entry is a file named by its key under <dir>/<first two hex
+ * digits of the key>/. Keys cover everything a value depends on,
+ * so entries are never invalidated, only evicted: get marks an
+ * entry as used, and put evicts the least recently used entries
+ * beyond the size bound. Entries are written to a temporary file
+ * and renamed, so concurrent runs see whole entries only.
+ */
+class content_cache {
+private:
+    std::string dir_;
+    uint64_t max_bytes_;
+
+public:
+    content_cache(const std::string& dir, uint64_t max_bytes):
+        dir_(dir), max_bytes_(max_bytes) {};
+
+    // @return false on a miss
+    bool get(const std::string& key, std::string& value) const;
+    // @return false if the entry cannot be written
+    bool put(const std::string& key, const std::string& value) const;
+    // removes the least recently used entries until at most
+    // max_bytes_ remain
+    // @return the size of the remaining entries in bytes
+    uint64_t evict() const;
+
+private:
+    std::string path(const std::string& key) const;
+};
+
+//! fingerprint of the inputs of a result
+struct fingerprint {
+    // combined fast hashes, to find candidates
+    std::string fast;
+    // combined SHA-256 digests, to confirm them
+    std::string sha256;
+};
+
+/**
+ * Local index of results by the fingerprint of their inputs, a text
+ * file with one "<fast> <sha256> <result file>" line per result.
+ * Every indexed result has a sidecar <result file>.fp holding its
+ * fingerprint and the SHA-256 of the result itself, so that results
+ * overwritten or removed since they were indexed are not returned.
+ */
+class fingerprint_index {
+private:
+    std::string file_;
+
+public:
+    fingerprint_index(const std::string& file): file_(file) {};
+
+    // an indexed result with the fast hash fast whose inputs have
+    // the SHA-256 digest sha256(), computed only if there are
+    // candidates
+    // @return "" if there is none
+    std::string find(
+        const std::string& fast,
+        const std::function<std::string()>& sha256) const;
+    // indexes result_file and writes its sidecar
+    // @return false if the index or the sidecar cannot be written
+    bool add(const fingerprint& fp, const std::string& result_file) const;
+};
+
+/**
+ * Reads a whole file into value
+ * @return false if the file cannot be read
+ */
+inline bool read_file_bytes(const std::string& file, std::string& value);
+
+/**
+ * Writes value to a file
+ * @return false in case of failure
+ */
+inline bool write_file_bytes(const std::string& file, const std::string& value);
+
+} // namespace
+
+#include <zkdoc/src/trusted_ai_cache.cpp>
+
+#endif
@@ -0,0 +1,218 @@
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <glob.h>
+#include <fstream>
+#include <iostream>
+
+namespace TrustedAI {
+
+inline mapped_file::~mapped_file()
+{
+    close();
+}
+
+inline bool mapped_file::open(const std::string& file)
+{
+    close();
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    if (st.st_size == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void* region = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (region == MAP_FAILED) return false;
+
+    // the file is read front to back exactly once
+    madvise(region, st.st_size, MADV_SEQUENTIAL);
+    region_ = region;
+    size_ = st.st_size;
+    return true;
+}
+
+inline void mapped_file::close()
+{
+    if (region_ != nullptr)
+        munmap(region_, size_);
+    region_ = nullptr;
+    size_ = 0;
+}
+
+inline bool csv_scanner::next_row()
+{
+    if (!row_done_)
+        skip_row();
+
+    // skip blank lines
+    while (pos_ < end_ && (*pos_ == '\n' || *pos_ == '\r')) {
+        if (*pos_ == '\n') ++row_;
+        ++pos_;
+    }
+
+    if (pos_ >= end_) return false;
+    ++row_;
+    row_done_ = false;
+    return true;
+}
+
+inline bool csv_scanner::next_field(const char*& field, size_t& len)
+{
+    if (row_done_) return false;
+
+    if (pos_ < end_ && *pos_ == '"') {
+        // quoted field, runs up to the closing quote
+        const char* start = ++pos_;
+        bool escaped = false;
+        while (pos_ < end_) {
+            if (*pos_ == '"') {
+                if (pos_ + 1 < end_ && pos_[1] == '"') {
+                    escaped = true;
+                    pos_ += 2;
+                    continue;
+                }
+                break;
+            }
+            if (*pos_ == '\n') ++row_;
+            ++pos_;
+        }
+
+        if (escaped) {
+            unescaped_.clear();
+            for(const char* p = start; p < pos_; ++p) {
+                unescaped_.push_back(*p);
+                if (*p == '"') ++p;
+            }
+            field = unescaped_.data();
+            len = unescaped_.size();
+        } else {
+            field = start;
+            len = pos_ - start;
+        }
+
+        // skip the closing quote and anything up to the separator
+        while (pos_ < end_ && *pos_ != separator_ && *pos_ != '\n')
+            ++pos_;
+    } else {
+        field = pos_;
+        while (pos_ < end_ && *pos_ != separator_ && *pos_ != '\n')
+            ++pos_;
+        len = pos_ - field;
+        if (len > 0 && field[len-1] == '\r')
+            --len;
+    }
+
+    if (pos_ < end_ && *pos_ == separator_) {
+        ++pos_;
+    } else {
+        // end of row (newline or end of input)
+        if (pos_ < end_) ++pos_;
+        row_done_ = true;
+    }
+    return true;
+}
+
+inline void csv_scanner::skip_row()
+{
+    const char* field;
+    size_t len;
+    while (next_field(field, len));
+}
+
+inline bool parse_uint64(const char* field, size_t len, uint64_t& value)
+{
+    const char* p = field;
+    const char* end = field + len;
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t')) --end;
+    if (p < end && *p == '+') ++p;
+    if (p == end) return false;
+
+    uint64_t v = 0;
+    for(; p < end; ++p) {
+        if (*p < '0' || *p > '9') return false;
+        const uint64_t digit = *p - '0';
+        if (v > (UINT64_MAX - digit) / 10) return false;
+        v = 10 * v + digit;
+    }
+    value = v;
+    return true;
+}
+
+inline bool parse_double(const char* field, size_t len, double& value)
+{
+    // strtod needs a terminated string, fields of the mapping are not
+    char buf[64];
+    std::string big;
+    const char* str;
+    if (len < sizeof(buf)) {
+        std::memcpy(buf, field, len);
+        buf[len] = '\0';
+        str = buf;
+    } else {
+        big.assign(field, len);
+        str = big.c_str();
+    }
+
+    char* end;
+    value = std::strtod(str, &end);
+    if (end == str) return false;
+    while (*end == ' ' || *end == '\t') ++end;
+    return *end == '\0';
+}
+
+inline bool expand_partitions(const std::string& spec, std::vector<std::string>& files)
+{
+    files.clear();
+    if (!spec.empty() && spec[0] == '@') {
+        const std::string manifest = spec.substr(1);
+        std::ifstream in(manifest);
+        if (!in) {
+            std::cout << "Unable to open manifest " << manifest << std::endl;
+            return false;
+        }
+        const size_t slash = manifest.rfind('/');
+        const std::string dir = (slash == std::string::npos) ? "" : manifest.substr(0, slash + 1);
+        std::string line;
+        while (std::getline(in, line)) {
+            const size_t b = line.find_first_not_of(" \t\r");
+            if (b == std::string::npos || line[b] == '#') continue;
+            const size_t e = line.find_last_not_of(" \t\r");
+            std::string file = line.substr(b, e - b + 1);
+            files.emplace_back((file[0] == '/') ? file : dir + file);
+        }
+        if (files.empty())
+            std::cout << "No partitions listed in " << manifest << std::endl;
+        return !files.empty();
+    }
+
+    if (spec.find_first_of("*?[") == std::string::npos) {
+        files.emplace_back(spec);
+        return true;
+    }
+
+    // glob sorts its matches
+    glob_t matches;
+    const int ret = glob(spec.c_str(), 0, nullptr, &matches);
+    if (ret == 0)
+        for(size_t i=0; i < matches.gl_pathc; ++i)
+            files.emplace_back(matches.gl_pathv[i]);
+    globfree(&matches);
+    if (files.empty())
+        std::cout << "No files match " << spec << std::endl;
+    return !files.empty();
+}
+
+} // namespace
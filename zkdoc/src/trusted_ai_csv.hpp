@@ -0,0 +1,100 @@
+#ifndef __TRUSTED_AI_CSV_HPP__
+#define __TRUSTED_AI_CSV_HPP__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace TrustedAI {
+
+/**
+ * Read-only memory mapping of a file. Empty files are valid
+ * and map to a null region of size 0.
+ */
+class mapped_file {
+private:
+    void* region_;
+    size_t size_;
+
+public:
+    mapped_file(): region_(nullptr), size_(0) {};
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    ~mapped_file();
+
+    // @return false if the file cannot be opened or mapped
+    bool open(const std::string& file);
+    void close();
+
+    const char* data() const { return static_cast<const char*>(region_); };
+    size_t size() const { return size_; };
+};
+
+/**
+ * Single pass scanner over CSV text in memory.
+ * Fields may be quoted (with "" as an escaped quote), quotes
+ * are removed from the returned fields. Rows end at \n or \r\n,
+ * blank lines are skipped. Usage:
+ *  while(scanner.next_row())
+ *      while(scanner.next_field(ptr, len))
+ *          ...
+ */
+class csv_scanner {
+private:
+    const char* pos_;
+    const char* end_;
+    char separator_;
+    bool row_done_;
+    size_t row_;
+    // unescaped copy of the last quoted field with "" in it
+    std::string unescaped_;
+
+public:
+    csv_scanner(const char* begin, const char* end, char separator=','):
+        pos_(begin), end_(end), separator_(separator), row_done_(true), row_(0) {};
+
+    // moves to the next non-blank row, false at end of input
+    bool next_row();
+    // reads the next field of the current row, false at end of row
+    // the field is valid until the next call
+    bool next_field(const char*& field, size_t& len);
+    // skips the remaining fields of the current row
+    void skip_row();
+    // 1-based line number of the current row
+    size_t row() const { return row_; };
+    // bytes left to scan
+    size_t remaining() const { return end_ - pos_; };
+};
+
+/**
+ * Parses an unsigned decimal integer, surrounding blanks allowed
+ * @return false on malformed input or overflow
+ */
+inline bool parse_uint64(const char* field, size_t len, uint64_t& value);
+
+/**
+ * Parses a floating point number, surrounding blanks allowed
+ * @return false on malformed input
+ */
+inline bool parse_double(const char* field, size_t len, double& value);
+
+/**
+ * Expands a data file argument into the list of its partitions:
+ *  - "@manifest" names a file listing one partition per line (blank
+ *    lines and lines starting with # are ignored, relative paths are
+ *    taken relative to the manifest),
+ *  - an argument with glob characters (*, ?, [) is matched against the
+ *    file system and the matches are sorted,
+ *  - anything else is a single file.
+ * The order of the partitions is the order of their rows.
+ * @return false (after reporting) if the manifest cannot be read or
+ * nothing matches
+ */
+inline bool expand_partitions(const std::string& spec, std::vector<std::string>& files);
+
+} // namespace
+
+#include <zkdoc/src/trusted_ai_csv.cpp>
+
+#endif
@@ -39,11 +39,11 @@ void data_source_integer<FieldT, N, M>::allocate()
 
 template<typename FieldT, size_t N, size_t M>
 void data_source_integer<FieldT, N, M>::set_values(
-    const std::vector<std::vector<uint64_t> >& values)
+    const std::vector<column_span<uint64_t> >& values)
 {
-    assert(values.size() == M);
+    assert(values.size() <= M);
     for(size_t i=0; i < M; ++i)
-        columns_[i]->set_values(values[i]);
+        columns_[i]->set_values((i < values.size()) ? values[i] : column_span<uint64_t>());
 
 }
 
@@ -103,11 +103,11 @@ void data_source_categorical<FieldT, N, M>::allocate()
 
 template<typename FieldT, size_t N, size_t M>
 void data_source_categorical<FieldT, N, M>::set_values(
-    const std::vector<std::vector<uint64_t> >& values)
+    const std::vector<column_span<uint64_t> >& values)
 {
-    assert(values.size() == M);
+    assert(values.size() <= M);
     for(size_t i=0; i < M; ++i)
-        columns_[i]->set_values(values[i]);
+        columns_[i]->set_values((i < values.size()) ? values[i] : column_span<uint64_t>());
 
 }
 
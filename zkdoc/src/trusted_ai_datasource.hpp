@@ -34,8 +34,11 @@ public:
         const std::string& annotation_prefix);
 
     void allocate();
-    // expects values[i] to contain the i^th column.
-    void set_values(const std::vector<std::vector<uint64_t> >& values);
+    // expects values[i] to contain the i^th column, missing
+    // columns are 0
+    void set_values(const std::vector<column_span<uint64_t> >& values);
+    void set_values(const std::vector<std::vector<uint64_t> >& values)
+    { set_values(column_spans(values)); };
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
 
@@ -64,8 +67,11 @@ public:
         const std::string& annotation_prefix);
 
     void allocate();
-    // expects values[i] to contain the i^th column.
-    void set_values(const std::vector<std::vector<uint64_t> >& values);
+    // expects values[i] to contain the i^th column, missing
+    // columns are 0
+    void set_values(const std::vector<column_span<uint64_t> >& values);
+    void set_values(const std::vector<std::vector<uint64_t> >& values)
+    { set_values(column_spans(values)); };
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
 
@@ -81,9 +87,6 @@ public:
     std::shared_ptr<data_source_categorical<FieldT, N, C>> categorical_features_;
     std::shared_ptr<data_source_integer<FieldT, N, M>> integer_features_;
     size_t size_;
-    std::vector<std::vector<uint64_t>> categorical_values_;
-    std::vector<std::vector<uint64_t>> integer_values_;
-    std::vector<std::vector<double>> numeric_values_;
 
 public:
     // hash related members
@@ -96,13 +99,15 @@ private:
     // hashers for the columns
     std::vector<std::shared_ptr<mimc_hash_categorical<FieldT, N, packing_categorical>>> cat_hashers_; //(C);
     std::vector<std::shared_ptr<mimc_hash_integer<FieldT, N, packing_integer>>> int_hashers_; //(M);
+    hash_mode mode_;
 
 public:
     data_source(
         protoboard<FieldT>& pb,
         size_t size,
-        const std::string& annotation_prefix=""): 
-        gadget<FieldT>(pb, annotation_prefix) 
+        const std::string& annotation_prefix="",
+        hash_mode mode=hash_mode::chain): 
+        gadget<FieldT>(pb, annotation_prefix), mode_(mode)
     {
         cat_hashers_.resize(C);
         int_hashers_.resize(M);
@@ -132,7 +137,8 @@ public:
                 this->pb,
                 categorical_features_->columns_[i],
                 categorical_col_hashes_[i],
-                "cat_hasher"));
+                "cat_hasher",
+                mode_));
             cat_hashers_[i]->allocate();
         }
 
@@ -141,19 +147,19 @@ public:
                 this->pb,
                 integer_features_->columns_[i],
                 integer_col_hashes_[i],
-                "int_hasher"));
+                "int_hasher",
+                mode_));
             int_hashers_[i]->allocate();
         }
     };
 
+    // the columns are read during the call, no copy is kept
     void set_values(
-        const std::vector<std::vector<uint64_t>>& categorical_values,
-        const std::vector<std::vector<uint64_t>>& integer_values) 
+        const std::vector<column_span<uint64_t>>& categorical_values,
+        const std::vector<column_span<uint64_t>>& integer_values) 
     {
-        categorical_values_ = categorical_values;
-        integer_values_ = integer_values;
-        categorical_features_->set_values(categorical_values_);
-        integer_features_->set_values(integer_values_);
+        categorical_features_->set_values(categorical_values);
+        integer_features_->set_values(integer_values);
     };
 
     void generate_r1cs_constraints()
@@ -197,9 +203,6 @@ public:
     std::shared_ptr<data_source_categorical<FieldT, N, C>> categorical_features_;
     std::shared_ptr<data_source_integer<FieldT, N, M>> integer_features_;
     size_t size_;
-    std::vector<std::vector<uint64_t>> categorical_values_;
-    std::vector<std::vector<uint64_t>> integer_values_;
-    std::vector<std::vector<double>> numeric_values_;
 
 public:
     data_source_public(
@@ -224,14 +227,13 @@ public:
         integer_features_->allocate();
     };
 
+    // the columns are read during the call, no copy is kept
     void set_values(
-        const std::vector<std::vector<uint64_t>>& categorical_values,
-        const std::vector<std::vector<uint64_t>>& integer_values) 
+        const std::vector<column_span<uint64_t>>& categorical_values,
+        const std::vector<column_span<uint64_t>>& integer_values) 
     {
-        categorical_values_ = categorical_values;
-        integer_values_ = integer_values;
-        categorical_features_->set_values(categorical_values_);
-        integer_features_->set_values(integer_values_);
+        categorical_features_->set_values(categorical_values);
+        integer_features_->set_values(integer_values);
     };
 
     void generate_r1cs_constraints()
@@ -0,0 +1,73 @@
+#include <cstring>
+
+namespace TrustedAI {
+
+//! initial number of slots, a power of two
+const size_t string_dictionary_initial_slots = 64;
+
+inline string_dictionary::string_dictionary():
+    offsets_(1, 0), slots_(string_dictionary_initial_slots, 0)
+{
+}
+
+inline uint64_t string_dictionary::hash(const char* value, size_t len)
+{
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for(size_t i=0; i < len; ++i) {
+        h ^= (unsigned char)value[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+inline uint32_t string_dictionary::find(const char* value, size_t len) const
+{
+    const uint64_t h = hash(value, len);
+    const size_t mask = slots_.size() - 1;
+    for(size_t i = h & mask; slots_[i] != 0; i = (i + 1) & mask) {
+        const uint32_t code = slots_[i] - 1;
+        if ((hashes_[code] == h) && (length(code) == len) &&
+            (std::memcmp(data(code), value, len) == 0))
+            return code;
+    }
+    return npos;
+}
+
+inline uint32_t string_dictionary::intern(const char* value, size_t len)
+{
+    const uint64_t h = hash(value, len);
+    size_t mask = slots_.size() - 1;
+    size_t i = h & mask;
+    for(; slots_[i] != 0; i = (i + 1) & mask) {
+        const uint32_t code = slots_[i] - 1;
+        if ((hashes_[code] == h) && (length(code) == len) &&
+            (std::memcmp(data(code), value, len) == 0))
+            return code;
+    }
+
+    const uint32_t code = hashes_.size();
+    arena_.append(value, len);
+    offsets_.emplace_back(arena_.size());
+    hashes_.emplace_back(h);
+    slots_[i] = code + 1;
+
+    if (2 * hashes_.size() > slots_.size())
+        grow();
+    return code;
+}
+
+inline void string_dictionary::grow()
+{
+    std::vector<uint32_t> slots(2 * slots_.size(), 0);
+    const size_t mask = slots.size() - 1;
+    for(uint32_t code=0; code < hashes_.size(); ++code) {
+        size_t i = hashes_[code] & mask;
+        while (slots[i] != 0)
+            i = (i + 1) & mask;
+        slots[i] = code + 1;
+    }
+    slots_.swap(slots);
+}
+
+} // namespace
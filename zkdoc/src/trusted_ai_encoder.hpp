@@ -0,0 +1,53 @@
+#ifndef __TRUSTED_AI_ENCODER_HPP__
+#define __TRUSTED_AI_ENCODER_HPP__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace TrustedAI {
+
+/**
+ * Dictionary of the distinct values of a categorical column.
+ * Values are interned in a single character arena and indexed
+ * by an open-addressing hash table (linear probing, load factor
+ * at most 1/2), so a lookup neither allocates nor copies the
+ * value. Codes are assigned in first-seen order.
+ */
+class string_dictionary {
+public:
+    static const uint32_t npos = UINT32_MAX;
+
+private:
+    std::string arena_;
+    // start of value k in the arena, offsets_[k+1] is its end
+    std::vector<uint64_t> offsets_;
+    std::vector<uint64_t> hashes_;
+    // code+1 of the value in the slot, 0 for empty slots
+    std::vector<uint32_t> slots_;
+
+public:
+    string_dictionary();
+
+    // code of the value, added if not present
+    uint32_t intern(const char* value, size_t len);
+    uint32_t intern(const std::string& value) { return intern(value.data(), value.size()); };
+    // code of the value, npos if not present
+    uint32_t find(const char* value, size_t len) const;
+
+    size_t size() const { return hashes_.size(); };
+    const char* data(uint32_t code) const { return arena_.data() + offsets_[code]; };
+    size_t length(uint32_t code) const { return offsets_[code+1] - offsets_[code]; };
+    std::string str(uint32_t code) const { return std::string(data(code), length(code)); };
+
+private:
+    static uint64_t hash(const char* value, size_t len);
+    void grow();
+};
+
+} // namespace
+
+#include <zkdoc/src/trusted_ai_encoder.cpp>
+
+#endif
@@ -0,0 +1,81 @@
+#include <cmath>
+#include <algorithm>
+
+namespace TrustedAI {
+
+template<uint64_t precision>
+size_t to_fixed_point(
+    const double* values,
+    size_t n,
+    uint64_t* signs,
+    uint64_t* magnitudes,
+    size_t bits)
+{
+    // 2^64 is exact as a double, and anything below it converts
+    const double limit = std::ldexp(1.0, bits);
+    const double k = double(precision);
+
+    // branch free: out of range values are flagged and clamped,
+    // the (rare) offender is located afterwards
+    uint64_t out_of_range = 0;
+    for(size_t i=0; i < n; ++i) {
+        const double f = values[i];
+        const double a = std::fabs(f) * k + 0.5;
+        const bool ok = (a < limit);   // false for nan and inf
+        signs[i] = (f < 0);
+        magnitudes[i] = uint64_t(ok ? a : 0.0);
+        out_of_range |= !ok;
+    }
+    if (!out_of_range)
+        return n;
+
+    for(size_t i=0; i < n; ++i)
+        if (!(std::fabs(values[i]) * k + 0.5 < limit))
+            return i;
+    return n;
+}
+
+template<uint64_t precision>
+size_t to_fixed_point(
+    const std::vector<double>& values,
+    size_t size,
+    std::vector<uint64_t>& signs,
+    std::vector<uint64_t>& magnitudes,
+    size_t bits)
+{
+    signs.assign(size, 0);
+    magnitudes.assign(size, 0);
+    const size_t n = std::min(values.size(), size);
+    const size_t bad = to_fixed_point<precision>(
+        values.data(), n, signs.data(), magnitudes.data(), bits);
+    return (bad == n) ? size : bad;
+}
+
+inline void from_fixed_point(
+    const uint64_t* signs,
+    const uint64_t* magnitudes,
+    size_t n,
+    uint64_t precision,
+    double* values)
+{
+    const double k = double(precision);
+    for(size_t i=0; i < n; ++i)
+        values[i] = (1.0 - 2.0 * double(signs[i])) * double(magnitudes[i]) / k;
+}
+
+template<typename FieldT>
+void fixed_point_to_field(
+    const uint64_t* signs,
+    const uint64_t* magnitudes,
+    size_t n,
+    std::vector<FieldT>& elements)
+{
+    elements.reserve(elements.size() + n);
+    for(size_t i=0; i < n; ++i) {
+        // through bigint, FieldT(long) would wrap magnitudes >= 2^63
+        FieldT v(libff::bigint<FieldT::num_limbs>(magnitudes[i]));
+        elements.emplace_back(signs[i] ? -v : v);
+    }
+}
+
+} // namespace
@@ -0,0 +1,75 @@
+#ifndef __TRUSTED_AI_FIXED_POINT_HPP__
+#define __TRUSTED_AI_FIXED_POINT_HPP__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <libff/algebra/fields/bigint.hpp>
+
+namespace TrustedAI {
+
+/**
+ * Batch conversions between doubles and the (s,v,k) fixed point
+ * form used by the signed gadgets, where the value is (-1)^s.v/k.
+ * Columns are kept as separate sign and magnitude arrays so that
+ * the loops are branch free and vectorize; the precision k is
+ * shared by the whole column.
+ *
+ * Rounding is half away from zero: v = floor(|f|.k + 0.5). A
+ * value is out of range when v does not fit in the given number
+ * of bits, or when it is not finite.
+ */
+
+/**
+ * Converts n doubles to sign and magnitude arrays
+ * @input bits bit width of the magnitudes, at most 64
+ * @return n on success, otherwise the index of the first value
+ * out of range (its magnitude is set to 0)
+ */
+template<uint64_t precision>
+size_t to_fixed_point(
+    const double* values,
+    size_t n,
+    uint64_t* signs,
+    uint64_t* magnitudes,
+    size_t bits);
+
+/**
+ * Converts a column into s and v arrays resized to size, missing
+ * values are padded with 0
+ * @return size on success, otherwise the index of the first value
+ * out of range
+ */
+template<uint64_t precision>
+size_t to_fixed_point(
+    const std::vector<double>& values,
+    size_t size,
+    std::vector<uint64_t>& signs,
+    std::vector<uint64_t>& magnitudes,
+    size_t bits);
+
+/**
+ * Converts n sign and magnitude pairs back to doubles
+ */
+inline void from_fixed_point(
+    const uint64_t* signs,
+    const uint64_t* magnitudes,
+    size_t n,
+    uint64_t precision,
+    double* values);
+
+/**
+ * Maps sign and magnitude pairs to the field elements (1-2s).v
+ */
+template<typename FieldT>
+void fixed_point_to_field(
+    const uint64_t* signs,
+    const uint64_t* magnitudes,
+    size_t n,
+    std::vector<FieldT>& elements);
+
+} // namespace
+
+#include <zkdoc/src/trusted_ai_fixed_point.cpp>
+
+#endif
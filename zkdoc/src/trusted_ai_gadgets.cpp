@@ -72,7 +72,8 @@ void signed_variable<FieldT>::generate_r1cs_constraints()
 template<typename FieldT>
 void signed_variable<FieldT>::generate_r1cs_witness()
 {
-    this->pb.val(iv) = this->value_;
+    // through bigint, FieldT(long) would wrap values >= 2^63
+    this->pb.val(iv) = FieldT(libff::bigint<FieldT::num_limbs>(this->value_));
     this->pb.val(is) = this->sign_;
     this->pb.val(ik) = this->k_;
     this->pack_gadget->generate_r1cs_witness_from_packed();
@@ -8,9 +8,13 @@
 #include <libsnark/gadgetlib1/gadgets/basic_gadgets.hpp>
 #include <libff/algebra/curves/alt_bn128/alt_bn128_pp.hpp>
 #include <libff/algebra/curves/edwards/edwards_pp.hpp>
+#include <zkdoc/src/trusted_ai_fixed_point.hpp>
 #include <vector>
 #include <memory>
 #include <tuple>
+#include <iostream>
+#include <cassert>
+#include <algorithm>
 
 using namespace libsnark;
 
@@ -32,6 +36,12 @@ const uint64_t float_precision_safe = 100;
 const size_t packing_categorical = 31;
 //! number of integer variables packed into a field element
 const size_t packing_integer = 6;
+//! number of model coefficients, float_bit_width bits and a sign
+//! bit each, packed into a field element
+const size_t packing_model = 2;
+//! version of the model hash: 1 hashed one signed coefficient per
+//! field element, 2 packs packing_model coefficients per element
+const uint64_t model_hash_version = 2;
 
 //! representation of a double as (s,v,k)
 //! Actual value is given by (-1)^s.v/k
@@ -45,11 +55,43 @@ typedef std::tuple<uint64_t, uint64_t, uint64_t> safe_tuple_t;
 template<size_t precision>
 safe_tuple_t safe_double(double f)
 {
-    uint64_t s, v, k;
-    s = (f >= 0)?0:1;
-    v = (abs(f) * precision + 0.5);
-    k = precision;
-    return {s, v, k};
+    uint64_t s, v;
+    to_fixed_point<precision>(&f, 1, &s, &v, float_bit_width);
+    return safe_tuple_t(s, v, precision);
+}
+
+/**
+ * Non-owning view of a column of witness values. Gadgets read the
+ * values straight from the caller's storage (a Dataset column, an
+ * Arrow buffer) during set_values and keep no copy; the column is
+ * 0-extended to the size of the gadget, so a view may be shorter
+ * than the gadget, or empty.
+ */
+template<typename T>
+class column_span {
+private:
+    const T* data_;
+    size_t size_;
+
+public:
+    column_span(): data_(nullptr), size_(0) {};
+    column_span(const T* data, size_t size): data_(data), size_(size) {};
+    column_span(const std::vector<T>& values): data_(values.data()), size_(values.size()) {};
+
+    size_t size() const { return size_; };
+    const T* data() const { return data_; };
+    const T& operator[](size_t i) const { return data_[i]; };
+    //! value i, 0 past the end of the column
+    T get(size_t i) const { return (i < size_) ? data_[i] : T(0); };
+};
+
+/**
+ * Views over the columns of a matrix stored column by column
+ */
+template<typename T>
+std::vector<column_span<T>> column_spans(const std::vector<std::vector<T>>& columns)
+{
+    return std::vector<column_span<T>>(columns.begin(), columns.end());
 }
 
 /**
@@ -100,11 +142,9 @@ class integer_variable_array : public gadget<FieldT> {
 public:
     /**
      *\param ivVec contains integer variables
-     *\param values_ contains the witness
      *\param size_ contains the size of the array
      */
     std::vector<integer_variable<FieldT> > ivVec;
-    std::vector<uint64_t> values_;
     size_t size_;
 
 public:
@@ -125,13 +165,11 @@ public:
 
     //! set up the witness
     //!\param values the array of values to be set
-    void set_values(const std::vector<uint64_t>& values) 
+    void set_values(column_span<uint64_t> values) 
     {
         //! The input array is 0-extend/truncated to size_ elements
-        this->values_ = values;
-        this->values_.resize(size_, 0);
         for(size_t i=0; i < this->size_; ++i)
-            ivVec[i].set_value(values_[i]);
+            ivVec[i].set_value(values.get(i));
     };
 
     void generate_r1cs_constraints(bool enforce_boolean = true);
@@ -181,7 +219,6 @@ template<typename FieldT>
 class categorical_variable_array : public gadget<FieldT> {
 public:
     std::vector<categorical_variable<FieldT> > ivVec;
-    std::vector<uint64_t> values_;
     size_t size_;
 
 public:
@@ -201,12 +238,10 @@ public:
             ivVec[i].allocate();
     };
 
-    void set_values(const std::vector<uint64_t>& values) 
+    void set_values(column_span<uint64_t> values) 
     {
-        this->values_ = values;
-        this->values_.resize(size_, 0);
         for(size_t i=0; i < size_; ++i)
-            ivVec[i].set_value(values_[i]);
+            ivVec[i].set_value(values.get(i));
     };
 
     void generate_r1cs_constraints(bool enforce_boolean=true);
@@ -259,6 +294,13 @@ public:
         this->k_ = std::get<2>(tup);
     };
 
+    void set_value(uint64_t sign, uint64_t value, uint64_t k)
+    {
+        this->sign_ = sign;
+        this->value_ = value;
+        this->k_ = k;
+    };
+
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
  
@@ -269,7 +311,6 @@ template<typename FieldT>
 class signed_variable_array : public gadget<FieldT> {
 public:
     std::vector<signed_variable<FieldT> > ivVec;
-    std::vector<double> values_;
     size_t size_;
 
 public:
@@ -289,11 +330,19 @@ public:
             ivVec[i].allocate();
     };
 
-    void set_values(const std::vector<double>& values) {
-        this->values_ = values;
-        this->values_.resize(size_, 0.0);
+    void set_values(column_span<double> values) {
+        // convert the whole column at once, then scatter
+        const size_t n = std::min(values.size(), size_);
+        std::vector<uint64_t> signs(size_, 0), magnitudes(size_, 0);
+        size_t bad = to_fixed_point<float_precision_safe>(
+            values.data(), n, signs.data(), magnitudes.data(), float_bit_width);
+        if (bad != n)
+            std::cerr << "Value " << values[bad] << " at " << bad 
+                << " exceeds " << float_bit_width << " bits at precision " 
+                << float_precision_safe << std::endl;
+        assert(bad == n);
         for(size_t i=0; i < size_; ++i)
-            ivVec[i].set_value(values_[i]);
+            ivVec[i].set_value(signs[i], magnitudes[i], float_precision_safe);
     };
 
     void set_values(const std::vector<safe_tuple_t>& values) {
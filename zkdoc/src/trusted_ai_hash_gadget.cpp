@@ -3,6 +3,26 @@ using namespace libsnark;
 
 namespace TrustedAI {
 
+inline bool parse_hash_mode(const std::string& name, hash_mode& mode)
+{
+    if (name == "chain") {
+        mode = hash_mode::chain;
+        return true;
+    }
+    if (name == "tree") {
+        mode = hash_mode::tree;
+        return true;
+    }
+    return false;
+}
+
+inline bool hash_mode_of_version(uint64_t version, hash_mode& mode)
+{
+    if (version != uint64_t(hash_mode::chain) && version != uint64_t(hash_mode::tree))
+        return false;
+    mode = hash_mode(version);
+    return true;
+}
 
 template<typename FieldT>
 mimc_cipher<FieldT>::mimc_cipher(
@@ -17,6 +37,14 @@ mimc_cipher<FieldT>::mimc_cipher(
 
 }
 
+template<typename FieldT>
+const std::vector<FieldT>& mimc_cipher<FieldT>::round_constants()
+{
+    static const std::vector<FieldT> constants(
+        std::begin(mimc_round_constants), std::end(mimc_round_constants));
+    return constants;
+}
+
 template<typename FieldT>
 void mimc_cipher<FieldT>::allocate()
 {
@@ -36,11 +64,13 @@ void mimc_cipher<FieldT>::generate_r1cs_constraints()
             1,
             input_), "intermediate_[0] = input[0]");
 
+    const auto& rc = round_constants();
     for(size_t i=0; i < ROUNDS; ++i) {
+        const linear_combination<FieldT> a = intermediate_inputs_[i] + key_ + rc[i];
         this->pb.add_r1cs_constraint(
             r1cs_constraint<FieldT>(
-                intermediate_inputs_[i] + key_ + round_constants_[i],
-                intermediate_inputs_[i] + key_ + round_constants_[i],
+                a,
+                a,
                 intermediate_lc2_[i]), "a=input+key+rc");
         this->pb.add_r1cs_constraint(
             r1cs_constraint<FieldT>(
@@ -54,7 +84,7 @@ void mimc_cipher<FieldT>::generate_r1cs_constraints()
                 intermediate_lc6_[i]), "a6=a4*a2");
         this->pb.add_r1cs_constraint(
             r1cs_constraint<FieldT>(
-                intermediate_inputs_[i] + key_ + round_constants_[i],
+                a,
                 intermediate_lc6_[i],
                 intermediate_inputs_[i+1]), "input[i+1]=f(input[i])");
     }
@@ -69,18 +99,25 @@ void mimc_cipher<FieldT>::generate_r1cs_constraints()
 template<typename FieldT>
 void mimc_cipher<FieldT>::generate_r1cs_witness()
 {
-    this->pb.val(intermediate_inputs_[0]) = this->pb.val(input_);
+    // the rounds are evaluated on field elements, only the values
+    // of the cipher's own variables are written to the protoboard
+    const auto& rc = round_constants();
+    const FieldT key = this->pb.val(key_);
+    FieldT x = this->pb.val(input_);
+    this->pb.val(intermediate_inputs_[0]) = x;
     for(size_t i=0; i < ROUNDS; ++i) {
-        pb_linear_combination<FieldT> lc;
-        lc.assign(this->pb, intermediate_inputs_[i] + key_ + round_constants_[i]);
-        lc.evaluate(this->pb);
-        this->pb.val(intermediate_lc2_[i]) = this->pb.lc_val(lc) * this->pb.lc_val(lc);
-        this->pb.val(intermediate_lc4_[i]) = this->pb.val(intermediate_lc2_[i]) * this->pb.val(intermediate_lc2_[i]);
-        this->pb.val(intermediate_lc6_[i]) = this->pb.val(intermediate_lc4_[i]) * this->pb.val(intermediate_lc2_[i]);
-        this->pb.val(intermediate_inputs_[i+1]) = this->pb.lc_val(lc) * this->pb.val(intermediate_lc6_[i]);
+        const FieldT a = x + key + rc[i];
+        const FieldT a2 = a * a;
+        const FieldT a4 = a2 * a2;
+        const FieldT a6 = a4 * a2;
+        x = a * a6;
+        this->pb.val(intermediate_lc2_[i]) = a2;
+        this->pb.val(intermediate_lc4_[i]) = a4;
+        this->pb.val(intermediate_lc6_[i]) = a6;
+        this->pb.val(intermediate_inputs_[i+1]) = x;
     }
     
-    this->pb.val(hash_) = this->pb.val(intermediate_inputs_[ROUNDS]) + this->pb.val(key_);
+    this->pb.val(hash_) = x + key;
 }
 
 
@@ -88,18 +125,45 @@ template<typename FieldT, size_t N, size_t P>
 void mimc_hash_column<FieldT, N, P>::allocate()
 {
     size_t num_hashers = mimc_hashers_.size();
+    size_t num_leaves = libff::div_ceil(num_hashers, leaf_chunks());
     intermediate_keys_.allocate(this->pb, num_hashers+1, "intermediate_keys");
     packed_input_.allocate(this->pb, num_hashers, "packed_input");
 
     for(size_t i=0; i < mimc_hashers_.size(); ++i) {
+        const size_t key = (i % leaf_chunks() == 0) ? 0 : i;
         mimc_hashers_[i].reset(new mimc_cipher<FieldT>(
             this->pb,
             packed_input_[i],
-            intermediate_keys_[i],
+            intermediate_keys_[key],
             intermediate_keys_[i+1],
             "mimc_hasher_iterations"));
         mimc_hashers_[i]->allocate();
     }
+
+    // every combination removes a node
+    std::vector<pb_variable<FieldT>> nodes;
+    for(size_t j=0; j < num_leaves; ++j)
+        nodes.emplace_back(intermediate_keys_[std::min((j+1) * leaf_chunks(), num_hashers)]);
+    if (num_leaves > 1)
+        tree_nodes_.allocate(this->pb, num_leaves-1, "tree_nodes");
+    size_t next = 0;
+    while (nodes.size() > 1) {
+        std::vector<pb_variable<FieldT>> parents;
+        for(size_t j=0; j+1 < nodes.size(); j += 2) {
+            mimc_combiners_.emplace_back(new mimc_cipher<FieldT>(
+                this->pb,
+                nodes[j+1],
+                nodes[j],
+                tree_nodes_[next],
+                "mimc_combiner"));
+            mimc_combiners_.back()->allocate();
+            parents.emplace_back(tree_nodes_[next++]);
+        }
+        if (nodes.size() % 2 == 1)
+            parents.emplace_back(nodes.back());
+        nodes.swap(parents);
+    }
+    root_ = nodes[0];
 }
 
 template<typename FieldT, size_t N, size_t P>
@@ -129,40 +193,51 @@ void mimc_hash_column<FieldT, N, P>::generate_r1cs_constraints()
     // generate hasher constraints
     for(size_t i=0; i < num_hashers; ++i)
         mimc_hashers_[i]->generate_r1cs_constraints();
+    for(auto& combiner : mimc_combiners_)
+        combiner->generate_r1cs_constraints();
  
     this->pb.add_r1cs_constraint(
-        r1cs_constraint<FieldT>(intermediate_keys_[num_hashers], 1, hash_), "hash=keys[num_hashers]");
+        r1cs_constraint<FieldT>(root_, 1, hash_), "hash=root");
     
 }
 
 template<typename FieldT, size_t N, size_t P>
 void mimc_hash_column<FieldT, N, P>::generate_r1cs_witness()
 {
-    size_t num_hashers = mimc_hashers_.size();
     size_t chunk_size = FieldT::capacity()/P;
+    const FieldT x = Power<FieldT>::power_of_two(chunk_size);
+    const size_t num_hashers = mimc_hashers_.size();
        
     this->pb.val(intermediate_keys_[0]) = FieldT::zero();
     
     // generate packed field elements
-    for(size_t i=0; i < N; i=i+P) {
-        size_t u = ((i+P) > N)?N:(i+P);
-        FieldT x = Power<FieldT>::power_of_two(chunk_size);
-        linear_combination<FieldT> lc = input_[u-1];
-        for(ssize_t j=u-2; j >= ssize_t(i); --j)
-            lc = input_[size_t(j)] + x * lc;
-        
-        pb_linear_combination<FieldT> plc;
-        plc.assign(this->pb, lc);
-        plc.evaluate(this->pb);
-        this->pb.val(packed_input_[i/P]) = this->pb.lc_val(plc);
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for(size_t c=0; c < num_hashers; ++c) {
+        const size_t u = std::min((c+1)*P, N);
+        FieldT packed = FieldT::zero();
+        for(size_t j=u; j > c*P; --j)
+            packed = this->pb.val(input_[j-1]) + x * packed;
+        this->pb.val(packed_input_[c]) = packed;
     }
 
-    // generate hasher witnesses
-    for(size_t i=0; i < mimc_hashers_.size(); ++i)
-        mimc_hashers_[i]->generate_r1cs_witness();
+    // generate hasher witnesses, one leaf per thread, then the
+    // combiners in level order. The ciphers only write the values
+    // of their own variables, so the leaves can run in parallel.
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for(size_t l=0; l < libff::div_ceil(num_hashers, leaf_chunks()); ++l) {
+        const size_t end = std::min((l+1) * leaf_chunks(), num_hashers);
+        for(size_t i=l * leaf_chunks(); i < end; ++i)
+            mimc_hashers_[i]->generate_r1cs_witness();
+    }
+    for(auto& combiner : mimc_combiners_)
+        combiner->generate_r1cs_witness();
 
     // set the final hash value
-    this->pb.val(hash_) = this->pb.val(intermediate_keys_[num_hashers]);
+    this->pb.val(hash_) = this->pb.val(root_);
 }
 
 template<typename FieldT, size_t N, size_t P>
@@ -173,7 +248,8 @@ void mimc_hash_integer<FieldT, N, P>::allocate()
         this->pb,
         input_->get_pb_vals(),
         hash_intermediate_,
-        "mimc_hasher"));
+        "mimc_hasher",
+        mode_));
 
     mimc_hasher_->allocate();
 
@@ -208,7 +284,8 @@ void mimc_hash_categorical<FieldT, N, P>::allocate()
         this->pb,
         input_->get_pb_vals(),
         hash_intermediate_,
-        "mimc_hasher"));
+        "mimc_hasher",
+        mode_));
     mimc_final_hasher_.reset(new mimc_cipher<FieldT>(
         this->pb,
         input_->vsize_,
@@ -238,6 +315,8 @@ void mimc_hash_categorical<FieldT, N, P>::generate_r1cs_witness()
 template<typename FieldT, size_t N, size_t P>
 void mimc_hash_signed<FieldT, N, P>::allocate()
 {
+    // a chunk holds the magnitude and the sign bit of each value
+    assert(FieldT::capacity()/P > float_bit_width);
     hash_intermediate_.allocate(this->pb, "hash_intermediate");
     for(size_t i=0; i < N; ++i)
         sign_free_vals[i].allocate(this->pb, "sign_free_vals");
@@ -264,13 +343,14 @@ void mimc_hash_signed<FieldT, N, P>::generate_r1cs_constraints()
 
     auto input_vals = input_->get_pb_vals();
     auto input_signs = input_->get_pb_vals_signs();
+    const FieldT sign_bit = Power<FieldT>::power_of_two(float_bit_width);
 
     for(size_t i=0; i < N; ++i) {
         this->pb.add_r1cs_constraint(
             r1cs_constraint<FieldT>(
-                input_vals[i],
-                1 - 2*input_signs[i],
-                sign_free_vals[i]), "sign_free_val[i] = (1-2s[i]).v[i]");
+                input_vals[i] + sign_bit * input_signs[i],
+                1,
+                sign_free_vals[i]), "sign_free_val[i] = v[i] + 2^w.s[i]");
     }
                 
     mimc_hasher_->generate_r1cs_constraints();
@@ -283,15 +363,379 @@ void mimc_hash_signed<FieldT, N, P>::generate_r1cs_witness()
     auto input_vals = input_->get_pb_vals();
     auto input_signs = input_->get_pb_vals_signs();
 
+    const FieldT sign_bit = Power<FieldT>::power_of_two(float_bit_width);
+
     for(size_t i=0; i < N; ++i) {
-        this->pb.val(sign_free_vals[i]) = (FieldT::one() - FieldT(2)*this->pb.val(input_signs[i])) * this->pb.val(input_vals[i]);
+        this->pb.val(sign_free_vals[i]) = this->pb.val(input_vals[i]) + sign_bit * this->pb.val(input_signs[i]);
     }
 
     mimc_hasher_->generate_r1cs_witness();
     mimc_final_hasher_->generate_r1cs_witness();
 }
 
+template<typename FieldT, size_t W>
+void mimc_hash_row<FieldT, W>::allocate()
+{
+    intermediate_keys_.allocate(this->pb, W+1, "intermediate_keys");
+    for(size_t i=0; i < W; ++i) {
+        mimc_hashers_[i].reset(new mimc_cipher<FieldT>(
+            this->pb,
+            input_[i],
+            intermediate_keys_[i],
+            intermediate_keys_[i+1],
+            "mimc_row_hasher"));
+        mimc_hashers_[i]->allocate();
+    }
+}
+
+template<typename FieldT, size_t W>
+void mimc_hash_row<FieldT, W>::generate_r1cs_constraints()
+{
+    this->pb.add_r1cs_constraint(
+        r1cs_constraint<FieldT>(intermediate_keys_[0], 1, 0), "keys[0] = 0");
+    for(auto& hasher : mimc_hashers_)
+        hasher->generate_r1cs_constraints();
+    this->pb.add_r1cs_constraint(
+        r1cs_constraint<FieldT>(intermediate_keys_[W], 1, hash_), "hash=keys[W]");
+}
+
+template<typename FieldT, size_t W>
+void mimc_hash_row<FieldT, W>::generate_r1cs_witness()
+{
+    this->pb.val(intermediate_keys_[0]) = FieldT::zero();
+    for(auto& hasher : mimc_hashers_)
+        hasher->generate_r1cs_witness();
+    this->pb.val(hash_) = this->pb.val(intermediate_keys_[W]);
+}
+
+template<typename FieldT, size_t D>
+void mimc_merkle_path<FieldT, D>::allocate()
+{
+    path_.allocate(this->pb, D, "path");
+    index_bits_.allocate(this->pb, D, "index_bits");
+    left_.allocate(this->pb, D, "left");
+    right_.allocate(this->pb, D, "right");
+    nodes_.allocate(this->pb, D, "nodes");
+    for(size_t h=0; h < D; ++h) {
+        mimc_combiners_[h].reset(new mimc_cipher<FieldT>(
+            this->pb,
+            right_[h],
+            left_[h],
+            nodes_[h],
+            "mimc_combiner"));
+        mimc_combiners_[h]->allocate();
+    }
+}
+
+template<typename FieldT, size_t D>
+void mimc_merkle_path<FieldT, D>::generate_r1cs_constraints()
+{
+    linear_combination<FieldT> packed;
+    for(size_t h=0; h < D; ++h) {
+        generate_boolean_r1cs_constraint<FieldT>(this->pb, index_bits_[h], "index_bit");
+        packed = packed + Power<FieldT>::power_of_two(h) * index_bits_[h];
+
+        // the node is the right child if the bit is set
+        const pb_variable<FieldT>& node = (h == 0) ? leaf_ : nodes_[h-1];
+        this->pb.add_r1cs_constraint(
+            r1cs_constraint<FieldT>(
+                index_bits_[h],
+                path_[h] - node,
+                left_[h] - node), "left = b ? sibling : node");
+        this->pb.add_r1cs_constraint(
+            r1cs_constraint<FieldT>(
+                node + path_[h] - left_[h],
+                1,
+                right_[h]), "right = node + sibling - left");
+        mimc_combiners_[h]->generate_r1cs_constraints();
+    }
+
+    this->pb.add_r1cs_constraint(
+        r1cs_constraint<FieldT>(packed, 1, index_), "index = sum of bits");
+    this->pb.add_r1cs_constraint(
+        r1cs_constraint<FieldT>(nodes_[D-1], 1, root_), "root = nodes[D-1]");
+}
+
+template<typename FieldT, size_t D>
+void mimc_merkle_path<FieldT, D>::generate_r1cs_witness(const std::vector<FieldT>& path)
+{
+    assert(path.size() == D);
+    const size_t index = this->pb.val(index_).as_ulong();
+    for(size_t h=0; h < D; ++h) {
+        const FieldT node = this->pb.val((h == 0) ? leaf_ : nodes_[h-1]);
+        const bool right = (index >> h) & 1;
+        this->pb.val(index_bits_[h]) = right ? FieldT::one() : FieldT::zero();
+        this->pb.val(path_[h]) = path[h];
+        this->pb.val(left_[h]) = right ? path[h] : node;
+        this->pb.val(right_[h]) = right ? node : path[h];
+        mimc_combiners_[h]->generate_r1cs_witness();
+    }
+    this->pb.val(root_) = this->pb.val(nodes_[D-1]);
+}
+
+template<typename FieldT, size_t W, size_t D>
+void mimc_row_membership<FieldT, W, D>::allocate()
+{
+    leaf_.allocate(this->pb, "row_leaf");
+    row_hasher_.reset(new mimc_hash_row<FieldT, W>(
+        this->pb,
+        input_,
+        leaf_,
+        "row_hasher"));
+    row_hasher_->allocate();
+    path_.reset(new mimc_merkle_path<FieldT, D>(
+        this->pb,
+        leaf_,
+        root_,
+        index_,
+        "row_path"));
+    path_->allocate();
+}
+
+template<typename FieldT, size_t W, size_t D>
+void mimc_row_membership<FieldT, W, D>::generate_r1cs_constraints()
+{
+    row_hasher_->generate_r1cs_constraints();
+    path_->generate_r1cs_constraints();
+}
+
+template<typename FieldT, size_t W, size_t D>
+void mimc_row_membership<FieldT, W, D>::generate_r1cs_witness(const std::vector<FieldT>& path)
+{
+    row_hasher_->generate_r1cs_witness();
+    path_->generate_r1cs_witness(path);
+}
+
+
+template<typename FieldT>
+FieldT mimc_encrypt(const FieldT& input, const FieldT& key)
+{
+    const auto& round_constants = mimc_cipher<FieldT>::round_constants();
+    FieldT x = input;
+    for(size_t i=0; i < mimc_cipher<FieldT>::ROUNDS; ++i) {
+        const FieldT a = x + key + round_constants[i];
+        const FieldT a2 = a * a;
+        const FieldT a4 = a2 * a2;
+        x = a * (a4 * a2);
+    }
+    return x + key;
+}
 
+/**
+ * Packs values into one field element, as the packing
+ * constraints of mimc_hash_column do
+ */
+template<typename FieldT, size_t P>
+FieldT mimc_pack_chunk(const uint64_t* values, size_t n)
+{
+    static const FieldT x = Power<FieldT>::power_of_two(FieldT::capacity()/P);
+    FieldT packed = FieldT::zero();
+    for(size_t j=n; j > 0; --j)
+        packed = FieldT(libff::bigint<FieldT::num_limbs>(values[j-1])) + x * packed;
+    return packed;
+}
 
+template<typename FieldT, size_t N, size_t P>
+FieldT mimc_hash_signed_values(
+    const uint64_t* signs,
+    const uint64_t* magnitudes,
+    size_t size)
+{
+    static const FieldT x = Power<FieldT>::power_of_two(FieldT::capacity()/P);
+    static const FieldT sign_bit = Power<FieldT>::power_of_two(float_bit_width);
+    assert(size <= N);
+
+    FieldT key = FieldT::zero();
+    for(size_t c=0; c < libff::div_ceil(N, P); ++c) {
+        FieldT packed = FieldT::zero();
+        for(size_t j=std::min((c+1)*P, N); j > c*P; --j) {
+            const FieldT value = (j-1 < size) ?
+                FieldT(libff::bigint<FieldT::num_limbs>(magnitudes[j-1])) + sign_bit * FieldT(signs[j-1]) :
+                FieldT::zero();
+            packed = value + x * packed;
+        }
+        key = mimc_encrypt(packed, key);
+    }
+    return mimc_encrypt(FieldT(libff::bigint<FieldT::num_limbs>(size)), key);
+}
+
+template<typename FieldT, size_t N, size_t P>
+bool mimc_column_hasher<FieldT, N, P>::consistent() const
+{
+    const size_t complete = size_ / P;
+    const size_t num_leaves = (complete == chunks) ?
+        libff::div_ceil(chunks, leaf_chunks()) : complete / leaf_chunks();
+    return size_ <= N && tail_.size() == size_ % P && leaves_.size() == num_leaves;
+}
+
+/**
+ * Chains chunks of P values under key
+ */
+template<typename FieldT, size_t P>
+FieldT mimc_chain_chunks(const uint64_t* values, size_t nchunks, FieldT key)
+{
+    for(size_t c=0; c < nchunks; ++c)
+        key = mimc_encrypt(mimc_pack_chunk<FieldT, P>(values + c*P, P), key);
+    return key;
+}
+
+template<typename FieldT, size_t N, size_t P>
+void mimc_column_hasher<FieldT, N, P>::append(const uint64_t* values, size_t n)
+{
+    assert(size_ + n <= N);
+    const size_t leaf_size = leaf_chunks() * P;
+    size_t i = 0;
+    while (i < n) {
+        // complete leaves at a leaf boundary, in parallel
+        const size_t num_leaves = (n - i) / leaf_size;
+        if (mode_ == hash_mode::tree && size_ % leaf_size == 0 && num_leaves > 0) {
+            std::vector<FieldT> leaves(num_leaves);
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+            for(size_t j=0; j < num_leaves; ++j)
+                leaves[j] = mimc_chain_chunks<FieldT, P>(
+                    values + i + j*leaf_size, leaf_chunks(), FieldT::zero());
+            leaves_.insert(leaves_.end(), leaves.begin(), leaves.end());
+            i += num_leaves * leaf_size;
+            size_ += num_leaves * leaf_size;
+            continue;
+        }
+
+        tail_.emplace_back(values[i++]);
+        ++size_;
+        if (tail_.size() < P)
+            continue;
+        key_ = mimc_encrypt(mimc_pack_chunk<FieldT, P>(tail_.data(), P), key_);
+        tail_.clear();
+        const size_t complete = size_ / P;
+        if (complete % leaf_chunks() == 0 || complete == chunks) {
+            leaves_.emplace_back(key_);
+            key_ = FieldT::zero();
+        }
+    }
+}
+
+template<typename FieldT, size_t N, size_t P>
+FieldT mimc_column_hasher<FieldT, N, P>::hash() const
+{
+    // the partial chunk, then chunks of padding up to N values
+    FieldT key = key_;
+    std::vector<FieldT> nodes = leaves_;
+    for(size_t c = size_ / P; c < chunks; ++c) {
+        const FieldT packed = (c == size_ / P) ?
+            mimc_pack_chunk<FieldT, P>(tail_.data(), tail_.size()) : FieldT::zero();
+        key = mimc_encrypt(packed, key);
+        if ((c+1) % leaf_chunks() == 0 || c+1 == chunks) {
+            nodes.emplace_back(key);
+            key = FieldT::zero();
+        }
+    }
+
+    // combine pairwise as mimc_hash_column does
+    while (nodes.size() > 1) {
+        std::vector<FieldT> parents;
+        for(size_t j=0; j+1 < nodes.size(); j += 2)
+            parents.emplace_back(mimc_encrypt(nodes[j+1], nodes[j]));
+        if (nodes.size() % 2 == 1)
+            parents.emplace_back(nodes.back());
+        nodes.swap(parents);
+    }
+    return mimc_encrypt(FieldT(libff::bigint<FieldT::num_limbs>(size_)), nodes[0]);
+}
+
+template<typename FieldT>
+FieldT mimc_row_leaf(const uint64_t* values, size_t n)
+{
+    FieldT key = FieldT::zero();
+    for(size_t i=0; i < n; ++i)
+        key = mimc_encrypt(FieldT(libff::bigint<FieldT::num_limbs>(values[i])), key);
+    return key;
+}
+
+template<typename FieldT>
+FieldT mimc_hash_fields(const FieldT* values, size_t n)
+{
+    FieldT key = FieldT::zero();
+    for(size_t i=0; i < n; ++i)
+        key = mimc_encrypt(values[i], key);
+    return key;
+}
+
+template<typename FieldT>
+FieldT mimc_merkle_empty(size_t h)
+{
+    // computed once per field, for any depth that fits a size_t
+    static const std::vector<FieldT> empty = [] {
+        std::vector<FieldT> nodes(1, FieldT::zero());
+        for(size_t i=0; i < 64; ++i)
+            nodes.emplace_back(mimc_encrypt(nodes.back(), nodes.back()));
+        return nodes;
+    }();
+    return empty[h];
+}
+
+template<typename FieldT, size_t D>
+mimc_merkle_tree<FieldT, D>::mimc_merkle_tree(const std::vector<FieldT>& leaves)
+{
+    assert(leaves.size() <= (size_t(1) << D));
+    levels_.resize(D+1);
+    levels_[0] = leaves;
+    for(size_t h=0; h < D; ++h) {
+        auto& nodes = levels_[h];
+        auto& parents = levels_[h+1];
+        parents.resize(libff::div_ceil(nodes.size(), 2));
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+        for(size_t j=0; j < parents.size(); ++j) {
+            const FieldT& right = (2*j+1 < nodes.size()) ? nodes[2*j+1] : mimc_merkle_empty<FieldT>(h);
+            parents[j] = mimc_encrypt(right, nodes[2*j]);
+        }
+    }
+}
+
+template<typename FieldT, size_t D>
+std::vector<FieldT> mimc_merkle_tree<FieldT, D>::path(size_t index) const
+{
+    std::vector<FieldT> siblings;
+    for(size_t h=0; h < D; ++h, index >>= 1) {
+        const size_t sibling = index ^ 1;
+        siblings.emplace_back((sibling < levels_[h].size()) ?
+            levels_[h][sibling] : mimc_merkle_empty<FieldT>(h));
+    }
+    return siblings;
+}
+
+template<typename FieldT, size_t D>
+void mimc_merkle_frontier<FieldT, D>::append(const FieldT& leaf)
+{
+    assert(size_ < (size_t(1) << D));
+    // climb while the node is a right child, combining it with
+    // the left sibling kept in the frontier
+    FieldT node = leaf;
+    size_t h = 0;
+    for(size_t index = size_; h < D && (index & 1); ++h, index >>= 1)
+        node = mimc_encrypt(node, frontier_[h]);
+    frontier_[h] = node;
+    ++size_;
+}
+
+template<typename FieldT, size_t D>
+FieldT mimc_merkle_frontier<FieldT, D>::root() const
+{
+    if (size_ == (size_t(1) << D))
+        return frontier_[D];
+    // path of the first empty leaf, its left siblings are in the
+    // frontier and its right siblings are empty
+    FieldT node = FieldT::zero();
+    for(size_t h=0; h < D; ++h) {
+        if ((size_ >> h) & 1)
+            node = mimc_encrypt(node, frontier_[h]);
+        else
+            node = mimc_encrypt(mimc_merkle_empty<FieldT>(h), node);
+    }
+    return node;
+}
 
 } // end of namespace
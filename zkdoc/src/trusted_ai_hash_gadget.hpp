@@ -28,77 +28,67 @@ public:
 template<typename FieldT, size_t N, size_t P>
 class mimc_hash_column;
 
+/**
+ * Structure of a column hash, its value is the version of the
+ * data handles with such hashes.
+ * chain: the packed chunks are chained, each chunk is encrypted
+ *  under the output of the previous one (from key 0).
+ * tree: chains of mimc_tree_leaf_chunks chunks are the leaves of
+ *  a binary tree, a parent is the right child encrypted under
+ *  the left one and an odd node is carried to the next level.
+ *  Leaves can be hashed in parallel.
+ * Either way the root is encrypted under the size of the column.
+ */
+enum class hash_mode {
+    chain = 1,
+    tree = 2
+};
+
+//! chunks chained in a leaf of the tree mode
+const size_t mimc_tree_leaf_chunks = 8;
+
+/**
+ * Parse a mode name (chain|tree)
+ * @return false if the name is unknown
+ */
+inline bool parse_hash_mode(const std::string& name, hash_mode& mode);
+
+/**
+ * Parse a data handle version into a mode
+ * @return false if the version is unknown
+ */
+inline bool hash_mode_of_version(uint64_t version, hash_mode& mode);
+
+// round constants of the MiMC cipher, shared by the gadget
+// and the native implementation
+const uint64_t mimc_round_constants[64] = {
+    42, 43, 170, 2209,
+    16426, 78087, 279978, 823517,
+    2097194, 4782931, 10000042, 19487209,
+    35831850, 62748495, 105413546, 170859333,
+    268435498, 410338651, 612220074, 893871697,
+    1280000042, 1801088567, 2494357930, 3404825421,
+    4586471466, 6103515587, 8031810218, 10460353177,
+    13492928554, 17249876351, 21870000042, 27512614133,
+    34359738410, 42618442955, 52523350186, 64339296833,
+    78364164138, 94931877159, 114415582634, 137231006717,
+    163840000042, 194754273907, 230539333290, 271818611081,
+    319277809706, 373669453167, 435817657258, 506623120485,
+    587068342314, 678223072891, 781250000042, 897410677873,
+    1028071702570, 1174711139799, 1338925210026, 1522435234413,
+    1727094849578, 1954897493219, 2207984167594, 2488651484857,
+    2799360000042, 3142742835999, 3521614606250, 3938980639125
+};
+
 template<typename FieldT>
 class mimc_cipher : public gadget<FieldT> {
 public:
     static const size_t ROUNDS = 64;
     pb_variable<FieldT> input_, key_, hash_;
-    std::vector<FieldT> round_constants_ {
-		42,
-		43,
-		170,
-		2209,
-		16426,
-		78087,
-		279978,
-		823517,
-		2097194,
-		4782931,
-		10000042,
-		19487209,
-		35831850,
-		62748495,
-		105413546,
-		170859333,
-		268435498,
-		410338651,
-		612220074,
-		893871697,
-		1280000042,
-		1801088567,
-		2494357930,
-		3404825421,
-		4586471466,
-		6103515587,
-		8031810218,
-		10460353177,
-		13492928554,
-		17249876351,
-		21870000042,
-		27512614133,
-		34359738410,
-		42618442955,
-		52523350186,
-		64339296833,
-		78364164138,
-		94931877159,
-		114415582634,
-		137231006717,
-		163840000042,
-		194754273907,
-		230539333290,
-		271818611081,
-		319277809706,
-		373669453167,
-		435817657258,
-		506623120485,
-		587068342314,
-		678223072891,
-		781250000042,
-		897410677873,
-		1028071702570,
-		1174711139799,
-		1338925210026,
-		1522435234413,
-		1727094849578,
-		1954897493219,
-		2207984167594,
-		2488651484857,
-		2799360000042,
-		3142742835999,
-		3521614606250,
-		3938980639125
-    };
+
+    // mimc_round_constants as field elements, converted once per
+    // field and shared by every cipher and by mimc_encrypt
+    static const std::vector<FieldT>& round_constants();
 
 private:
     pb_variable_array<FieldT> intermediate_inputs_;
@@ -127,21 +117,34 @@ public:
     pb_variable<FieldT> hash_;
 
 private:
+    hash_mode mode_;
+    // one per chunk, chunk c is hashed under intermediate_keys_[c],
+    // or intermediate_keys_[0] = 0 at the start of a leaf, into
+    // intermediate_keys_[c+1]
     std::vector<std::shared_ptr<mimc_cipher<FieldT>>> mimc_hashers_;
+    // parents of the tree, level by level
+    std::vector<std::shared_ptr<mimc_cipher<FieldT>>> mimc_combiners_;
     pb_variable_array<FieldT> packed_input_;
     pb_variable_array<FieldT> intermediate_keys_;
+    pb_variable_array<FieldT> tree_nodes_;
+    pb_variable<FieldT> root_;
 
 public:
     mimc_hash_column(
         protoboard<FieldT>& pb,
         const std::vector<pb_variable<FieldT>>& input,
         const pb_variable<FieldT>& hash,
-        const std::string& annotation_prefix=""):
+        const std::string& annotation_prefix="",
+        hash_mode mode=hash_mode::chain):
         gadget<FieldT>(pb, annotation_prefix),
-        input_(input), hash_(hash) {
+        input_(input), hash_(hash), mode_(mode) {
             mimc_hashers_.resize(libff::div_ceil(N, P));
         };
 
+    // chunks chained in a leaf, a chain is a single leaf
+    size_t leaf_chunks() const
+    { return (mode_ == hash_mode::chain) ? mimc_hashers_.size() : mimc_tree_leaf_chunks; };
+
     void allocate();
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
@@ -158,15 +161,17 @@ private:
     std::shared_ptr<mimc_hash_column<FieldT, N, P>> mimc_hasher_;
     std::shared_ptr<mimc_cipher<FieldT>> mimc_final_hasher_;
     pb_variable<FieldT> hash_intermediate_;
+    hash_mode mode_;
 
 public:
     mimc_hash_integer(
         protoboard<FieldT>& pb,
         const std::shared_ptr<integer_vector<FieldT, N>> input,
         const pb_variable<FieldT>& hash,
-        const std::string& annotation_prefix=""):
+        const std::string& annotation_prefix="",
+        hash_mode mode=hash_mode::chain):
         gadget<FieldT>(pb, annotation_prefix),
-        input_(input), hash_(hash) {};
+        input_(input), hash_(hash), mode_(mode) {};
 
     void allocate();
     void generate_r1cs_constraints();
@@ -183,21 +188,29 @@ private:
     std::shared_ptr<mimc_hash_column<FieldT, N, P>> mimc_hasher_;
     std::shared_ptr<mimc_cipher<FieldT>> mimc_final_hasher_;
     pb_variable<FieldT> hash_intermediate_;
+    hash_mode mode_;
 
 public:
     mimc_hash_categorical(
         protoboard<FieldT>& pb,
         const std::shared_ptr<categorical_vector<FieldT, N>> input,
         const pb_variable<FieldT>& hash,
-        const std::string& annotation_prefix=""):
+        const std::string& annotation_prefix="",
+        hash_mode mode=hash_mode::chain):
         gadget<FieldT>(pb, annotation_prefix),
-        input_(input), hash_(hash) {};
+        input_(input), hash_(hash), mode_(mode) {};
 
     void allocate();
     void generate_r1cs_constraints();
     void generate_r1cs_witness();
 };
 
+/**
+ * Hash of a signed vector of N values packed P to a chunk. A value
+ * (-1)^s.v enters the hash as v + s.2^float_bit_width, so that
+ * values of float_bit_width bits with their sign pack as integers
+ * do; the chain is finalized with the size of the vector.
+ */
 template<typename FieldT, size_t N, size_t P>
 class mimc_hash_signed : public gadget<FieldT> {
 public:
@@ -224,8 +237,232 @@ public:
     void generate_r1cs_witness();
 };
 
-//template<typename FieldT, size_t N, size_t C, size_t M>
-//class mimc_hash_datasource
+/**
+ * Hash of a row of W values, one value per cipher chained from
+ * key 0. These are the leaves of the row commitment of a data
+ * handle.
+ */
+template<typename FieldT, size_t W>
+class mimc_hash_row : public gadget<FieldT> {
+public:
+    pb_variable_array<FieldT> input_;
+    pb_variable<FieldT> hash_;
+
+private:
+    std::vector<std::shared_ptr<mimc_cipher<FieldT>>> mimc_hashers_;
+    pb_variable_array<FieldT> intermediate_keys_;
+
+public:
+    mimc_hash_row(
+        protoboard<FieldT>& pb,
+        const pb_variable_array<FieldT>& input,
+        const pb_variable<FieldT>& hash,
+        const std::string& annotation_prefix=""):
+        gadget<FieldT>(pb, annotation_prefix),
+        input_(input), hash_(hash) { mimc_hashers_.resize(W); };
+
+    void allocate();
+    void generate_r1cs_constraints();
+    void generate_r1cs_witness();
+};
+
+/**
+ * Membership of leaf_ at position index_ in a Merkle tree of
+ * depth D with root root_. A parent is the right child encrypted
+ * under the left one, as in the tree mode of the column hashes,
+ * and empty leaves are 0. The cost is D ciphers, independent of
+ * the number of leaves.
+ */
+template<typename FieldT, size_t D>
+class mimc_merkle_path : public gadget<FieldT> {
+public:
+    pb_variable<FieldT> leaf_, root_, index_;
+    // siblings from the leaf up
+    pb_variable_array<FieldT> path_;
+    // bits of index_, least significant first, 1 for a right child
+    pb_variable_array<FieldT> index_bits_;
+
+private:
+    pb_variable_array<FieldT> left_, right_, nodes_;
+    std::vector<std::shared_ptr<mimc_cipher<FieldT>>> mimc_combiners_;
+
+public:
+    mimc_merkle_path(
+        protoboard<FieldT>& pb,
+        const pb_variable<FieldT>& leaf,
+        const pb_variable<FieldT>& root,
+        const pb_variable<FieldT>& index,
+        const std::string& annotation_prefix=""):
+        gadget<FieldT>(pb, annotation_prefix),
+        leaf_(leaf), root_(root), index_(index) { mimc_combiners_.resize(D); };
+
+    void allocate();
+    void generate_r1cs_constraints();
+    // expects the values of leaf_ and index_, and the siblings
+    // as returned by mimc_merkle_tree::path
+    void generate_r1cs_witness(const std::vector<FieldT>& path);
+};
+
+/**
+ * Shows that a row of W values is the row index_ of a data handle
+ * with row commitment root_, for trees of depth D.
+ */
+template<typename FieldT, size_t W, size_t D>
+class mimc_row_membership : public gadget<FieldT> {
+public:
+    pb_variable_array<FieldT> input_;
+    pb_variable<FieldT> root_, index_;
+
+private:
+    pb_variable<FieldT> leaf_;
+    std::shared_ptr<mimc_hash_row<FieldT, W>> row_hasher_;
+    std::shared_ptr<mimc_merkle_path<FieldT, D>> path_;
+
+public:
+    mimc_row_membership(
+        protoboard<FieldT>& pb,
+        const pb_variable_array<FieldT>& input,
+        const pb_variable<FieldT>& root,
+        const pb_variable<FieldT>& index,
+        const std::string& annotation_prefix=""):
+        gadget<FieldT>(pb, annotation_prefix),
+        input_(input), root_(root), index_(index) {};
+
+    void allocate();
+    void generate_r1cs_constraints();
+    // expects the values of input_ and index_
+    void generate_r1cs_witness(const std::vector<FieldT>& path);
+};
+
+/**
+ * Native MiMC cipher, computes the hash_ of mimc_cipher
+ * for the given input_ and key_
+ */
+template<typename FieldT>
+FieldT mimc_encrypt(const FieldT& input, const FieldT& key);
+
+/**
+ * Native computation of the hash of mimc_hash_signed, for the
+ * fixed point representation of the values (see to_fixed_point)
+ * @input signs, magnitudes the first size values, 0 after them
+ */
+template<typename FieldT, size_t N, size_t P>
+FieldT mimc_hash_signed_values(
+    const uint64_t* signs,
+    const uint64_t* magnitudes,
+    size_t size);
+
+/**
+ * Native computation of the hashes of mimc_hash_integer and
+ * mimc_hash_categorical, for columns of N values packed P to
+ * a chunk. Chunks are chained within a leaf, each key depending
+ * only on the previous key and the chunk, so the hashes of the
+ * complete leaves, the key of the current leaf and the values of
+ * the partial chunk are enough to append more rows later. The
+ * hash is the same as if the column was hashed at once.
+ */
+template<typename FieldT, size_t N, size_t P>
+class mimc_column_hasher {
+public:
+    static const size_t packing = P;
+    static const size_t chunks = (N + P - 1) / P;
+
+    hash_mode mode_;
+    // chain key of the current leaf after its complete chunks
+    FieldT key_;
+    // values of the partial chunk, fewer than P
+    std::vector<uint64_t> tail_;
+    // hashes of the complete leaves
+    std::vector<FieldT> leaves_;
+    // number of values appended
+    size_t size_;
+
+public:
+    mimc_column_hasher(hash_mode mode=hash_mode::chain):
+        mode_(mode), key_(FieldT::zero()), size_(0) {};
+    mimc_column_hasher(
+        hash_mode mode,
+        const FieldT& key,
+        const std::vector<uint64_t>& tail,
+        const std::vector<FieldT>& leaves,
+        size_t size):
+        mode_(mode), key_(key), tail_(tail), leaves_(leaves), size_(size) {};
+
+    size_t leaf_chunks() const
+    { return (mode_ == hash_mode::chain) ? chunks : mimc_tree_leaf_chunks; };
+    // whether the state is that of size_ values
+    bool consistent() const;
+
+    // appends n values, at most N in total. In tree mode the
+    // complete leaves among them are hashed in parallel.
+    void append(const uint64_t* values, size_t n);
+    // hash of the column padded with 0 to N values, and finalized
+    // with its size
+    FieldT hash() const;
+};
+
+/**
+ * Native computation of the hash of mimc_hash_row
+ */
+template<typename FieldT>
+FieldT mimc_row_leaf(const uint64_t* values, size_t n);
+
+/**
+ * Native computation of the hash of mimc_hash_row over field
+ * elements, such as the column hashes of a column group
+ */
+template<typename FieldT>
+FieldT mimc_hash_fields(const FieldT* values, size_t n);
+
+/**
+ * Hash of an empty subtree of height h, an empty leaf is 0
+ */
+template<typename FieldT>
+FieldT mimc_merkle_empty(size_t h);
+
+/**
+ * Native Merkle tree of depth D over at most 2^D leaves, padded
+ * with empty leaves, as checked by mimc_merkle_path. Keeps every
+ * node, for the paths of the prover.
+ */
+template<typename FieldT, size_t D>
+class mimc_merkle_tree {
+private:
+    // nodes of height h, without the empty nodes at the end
+    std::vector<std::vector<FieldT>> levels_;
+
+public:
+    // the levels are hashed in parallel
+    mimc_merkle_tree(const std::vector<FieldT>& leaves);
+
+    FieldT root() const { return levels_[D].empty() ? mimc_merkle_empty<FieldT>(D) : levels_[D][0]; };
+    // siblings of leaf index, from the leaf up
+    std::vector<FieldT> path(size_t index) const;
+};
+
+/**
+ * Root of the tree of mimc_merkle_tree for leaves appended one at
+ * a time, keeping only the last complete left node of each height.
+ */
+template<typename FieldT, size_t D>
+class mimc_merkle_frontier {
+public:
+    // frontier_[h] is the last complete node of height h that is a
+    // left child, frontier_[D] the root once the tree is full
+    std::vector<FieldT> frontier_;
+    // number of leaves appended
+    size_t size_;
+
+public:
+    mimc_merkle_frontier():
+        frontier_(D+1, FieldT::zero()), size_(0) {};
+    mimc_merkle_frontier(const std::vector<FieldT>& frontier, size_t size):
+        frontier_(frontier), size_(size) {};
+
+    bool consistent() const { return frontier_.size() == D+1 && size_ <= (size_t(1) << D); };
+    void append(const FieldT& leaf);
+    FieldT root() const;
+};
 
 } // end of namespace    
 
@@ -12,18 +12,29 @@ namespace TrustedAI {
  * column. Model is a vector of M+1 coefficients.  
  * we put the offset (c_0) as the last element of the 
  * coefficient array.
- * Statement: Hashes[0...(C+M)], mHash, R2
+ * Statement: Hashes[0...(C+M-G*W)], GroupHashes[0...G-1], mHash, R2
  * Witness: there exists data (D) and model (LM) such that
  * Hash(D) = Hashes and Hash(LM) = mHash and LM achieves 
  * Rsquare accuracy of R2, when predicting the target column
- * from feature columns(C,..C+M-1).
+ * from feature columns(C,..C+M-1). The column hashes are those
+ * of the given hash_mode.
+ * Wide schemas commit to the last G*W of the M+1 integer columns
+ * in G groups of W columns, each group by the hash of the hashes
+ * of its columns (mimc_hash_row), so the statement has M+1-G*W
+ * column hashes and G group hashes, and grows by one input per
+ * group rather than per column.
  */
-template<typename FieldT, size_t N, size_t C, size_t M>
+template<typename FieldT, size_t N, size_t C, size_t M, size_t G=0, size_t W=1>
 class model_provenance_gadget : public gadget<FieldT> {
 public:
+    static_assert(G*W <= M, "the groups cover features only");
+    // integer columns committed one by one
+    static const size_t K = M+1 - G*W;
+
     // variables part of the statement
     pb_variable<FieldT> catColHashes_[C];
-    pb_variable<FieldT> intColHashes_[M+1];
+    pb_variable<FieldT> intColHashes_[K];
+    pb_variable_array<FieldT> groupHashes_;
     pb_variable<FieldT> modelHash_;
     pb_variable<FieldT> R2_;
     //@todo add data size as part of public input
@@ -35,27 +46,36 @@ private:
     std::shared_ptr<linear_regression_gadget<FieldT, N, M>> lin_reg_;
     std::shared_ptr<signed_variable<FieldT>> r2_;
     std::shared_ptr<size_selector_gadget<FieldT, M+1>> size_selector_w_;
-    std::shared_ptr<mimc_hash_signed<FieldT, M+1, 1>> model_hasher_;
+    std::shared_ptr<mimc_hash_signed<FieldT, M+1, packing_model>> model_hasher_;
+    std::vector<std::shared_ptr<mimc_hash_row<FieldT, W>>> group_hashers_;
     pb_variable_array<FieldT> selector_w_;
     pb_variable<FieldT> dsize_, wsize_;
     size_t size_;
 
+    // hash of integer column i, the target is column M
+    pb_variable<FieldT> column_hash(size_t i) const
+    {
+        return (i < M) ? data_->integer_col_hashes_[i] : target_->integer_col_hashes_[0];
+    }
+
 public:
     model_provenance_gadget(
         protoboard<FieldT>& pb,
         const size_t size,
-        const std::string& annotation_prefix):
+        const std::string& annotation_prefix,
+        hash_mode mode=hash_mode::chain):
         gadget<FieldT>(pb, annotation_prefix), size_(size)
     {
         // allocate the public variables first
         for(size_t i=0; i < C; ++i)
             catColHashes_[i].allocate(this->pb, "catColHash_"+std::to_string(i));
-        for(size_t i=0; i < (M+1); ++i)
+        for(size_t i=0; i < K; ++i)
             intColHashes_[i].allocate(this->pb, "intColHash_"+std::to_string(i));
+        groupHashes_.allocate(this->pb, G, "groupHash");
 
         modelHash_.allocate(this->pb, "modelHash");
         R2_.allocate(this->pb, "R2");
-        this->pb.set_input_sizes(C+M+3);
+        this->pb.set_input_sizes(C+K+G+2);
         
         // allocate other gadgets
         dsize_.allocate(this->pb, "dsize");
@@ -78,10 +98,10 @@ public:
         r2_.reset(new signed_variable<FieldT>(this->pb, "r2"));
         r2_->allocate();
 
-        data_.reset(new data_source<FieldT, N, C, M>(this->pb, size_, "data"));
+        data_.reset(new data_source<FieldT, N, C, M>(this->pb, size_, "data", mode));
         data_->allocate();
 
-        target_.reset(new data_source<FieldT, N, 0, 1>(this->pb, size_, "target"));
+        target_.reset(new data_source<FieldT, N, 0, 1>(this->pb, size_, "target", mode));
         target_->allocate();
 
         lin_reg_.reset(new linear_regression_gadget<FieldT, N, M>(
@@ -93,13 +113,25 @@ public:
             "linear regression"));
         lin_reg_->allocate();
 
-        model_hasher_.reset(new mimc_hash_signed<FieldT, M+1, 1>(
+        model_hasher_.reset(new mimc_hash_signed<FieldT, M+1, packing_model>(
             this->pb,
             model_,
             modelHash_,
             "model_hasher"));
         model_hasher_->allocate();
 
+        for(size_t g=0; g < G; ++g) {
+            pb_variable_array<FieldT> members;
+            for(size_t i=0; i < W; ++i)
+                members.emplace_back(column_hash(K + g*W + i));
+            group_hashers_.emplace_back(new mimc_hash_row<FieldT, W>(
+                this->pb,
+                members,
+                groupHashes_[g],
+                "group_hasher"));
+            group_hashers_.back()->allocate();
+        }
+
 
     };
 
@@ -116,6 +148,8 @@ public:
         target_->generate_r1cs_constraints();
         lin_reg_->generate_r1cs_constraints();
         model_hasher_->generate_r1cs_constraints();
+        for(auto& hasher : group_hashers_)
+            hasher->generate_r1cs_constraints();
         
         // match the hashes
         for(size_t i=0; i < C; ++i)
@@ -124,18 +158,12 @@ public:
                     catColHashes_[i],
                     1,
                     data_->categorical_col_hashes_[i]), "cat-hash-match");
-        for(size_t i=0; i < M; ++i)
+        for(size_t i=0; i < K; ++i)
             this->pb.add_r1cs_constraint(
                 r1cs_constraint<FieldT>(
                     intColHashes_[i],
                     1,
-                    data_->integer_col_hashes_[i]), "int-hash-match");
-        
-        this->pb.add_r1cs_constraint(
-            r1cs_constraint<FieldT>(
-                intColHashes_[M],
-                1,
-                target_->integer_col_hashes_[0]), "target-hash-match");
+                    column_hash(i)), (i < M) ? "int-hash-match" : "target-hash-match");
 
         // r2 match
         this->pb.add_r1cs_constraint(
@@ -145,14 +173,15 @@ public:
                 r2_->iv), "R2=r2");
     };
 
+    // columns are read in place, missing columns and rows are 0
     void generate_r1cs_witness( 
-        const std::vector<std::vector<uint64_t>>& categorical_matrix,
-        const std::vector<std::vector<uint64_t>>& integer_matrix,
-        const std::vector<std::vector<uint64_t>>& target,
-        const std::vector<double>& model_coefficients)
+        const std::vector<column_span<uint64_t>>& categorical_matrix,
+        const std::vector<column_span<uint64_t>>& integer_matrix,
+        const std::vector<column_span<uint64_t>>& target,
+        column_span<double> model_coefficients)
     {
-        assert(categorical_matrix.size() == C);
-        assert(integer_matrix.size() == M);
+        assert(categorical_matrix.size() <= C);
+        assert(integer_matrix.size() <= M);
         assert(model_coefficients.size() == M+1);
         assert(target.size() == 1);
        
@@ -163,18 +192,19 @@ public:
         model_->generate_r1cs_witness();
         data_->set_values(categorical_matrix, integer_matrix);
         data_->generate_r1cs_witness();
-        target_->set_values(std::vector<std::vector<uint64_t>>(), target);
+        target_->set_values(std::vector<column_span<uint64_t>>(), target);
         target_->generate_r1cs_witness();
         lin_reg_->generate_r1cs_witness();
         model_hasher_->generate_r1cs_witness();
         r2_->generate_r1cs_witness();
+        for(auto& hasher : group_hashers_)
+            hasher->generate_r1cs_witness();
  
         // copy the variables
         for(size_t i=0; i < C; ++i)
             this->pb.val(catColHashes_[i]) = this->pb.val(data_->categorical_col_hashes_[i]);
-        for(size_t i=0; i < M; ++i)
-            this->pb.val(intColHashes_[i]) = this->pb.val(data_->integer_col_hashes_[i]);
-        this->pb.val(intColHashes_[M]) = this->pb.val(target_->integer_col_hashes_[0]);
+        for(size_t i=0; i < K; ++i)
+            this->pb.val(intColHashes_[i]) = this->pb.val(column_hash(i));
         
 
         // R2
@@ -201,7 +231,7 @@ public:
 private:
     std::shared_ptr<linear_combination_gadget<FieldT, N, M>> lc_gadget_;
     std::shared_ptr<size_selector_gadget<FieldT, M+1>> size_selector_w_;
-    std::shared_ptr<mimc_hash_signed<FieldT, M+1, 1>> model_hasher_;
+    std::shared_ptr<mimc_hash_signed<FieldT, M+1, packing_model>> model_hasher_;
     std::shared_ptr<assert_equal_gadget<FieldT, N, float_precision_safe>> eq_gadget_;
 
     pb_variable_array<FieldT> selector_w_;
@@ -274,7 +304,7 @@ public:
             "eq_gadget"));
         eq_gadget_->allocate();
 
-        model_hasher_.reset(new mimc_hash_signed<FieldT, M+1, 1>(
+        model_hasher_.reset(new mimc_hash_signed<FieldT, M+1, packing_model>(
             this->pb,
             model_,
             model_hash_,
@@ -307,13 +337,14 @@ public:
         model_hasher_->generate_r1cs_constraints();
     };
 
+    // columns are read in place, missing columns and rows are 0
     void generate_r1cs_witness(
-        const std::vector<std::vector<uint64_t>>& categorical_matrix,
-        const std::vector<std::vector<uint64_t>>& integer_matrix,
-        const std::vector<double>& model_coefficients)
+        const std::vector<column_span<uint64_t>>& categorical_matrix,
+        const std::vector<column_span<uint64_t>>& integer_matrix,
+        column_span<double> model_coefficients)
     {
-        assert(categorical_matrix.size() == C);
-        assert(integer_matrix.size() == M);
+        assert(categorical_matrix.size() <= C);
+        assert(integer_matrix.size() <= M);
         assert(model_coefficients.size() == M+1);
 
         this->pb.val(dsize_) = size_;
@@ -339,6 +370,78 @@ public:
 
 };
 
+/**
+ * This gadget computes the hash of a model, as used in
+ * the provenance and inference statements.
+ * Model is a vector of M+1 coefficients.
+ * Statement: mHash
+ * Witness: there exists a model (LM) such that Hash(LM) = mHash
+ */
+template<typename FieldT, size_t M>
+class model_hash_gadget : public gadget<FieldT> {
+public:
+    // variables part of the statement
+    pb_variable<FieldT> modelHash_;
+
+private:
+    std::shared_ptr<signed_vector<FieldT, M+1>> model_;
+    std::shared_ptr<size_selector_gadget<FieldT, M+1>> size_selector_w_;
+    std::shared_ptr<mimc_hash_signed<FieldT, M+1, packing_model>> model_hasher_;
+    pb_variable_array<FieldT> selector_w_;
+    pb_variable<FieldT> wsize_;
+
+public:
+    model_hash_gadget(
+        protoboard<FieldT>& pb,
+        const std::string& annotation_prefix):
+        gadget<FieldT>(pb, annotation_prefix)
+    {
+        modelHash_.allocate(this->pb, "modelHash");
+        this->pb.set_input_sizes(1);
+
+        wsize_.allocate(this->pb, "wsize");
+        selector_w_.allocate(this->pb, M+1, "selector_w");
+        size_selector_w_.reset(new size_selector_gadget<FieldT, M+1>(
+            this->pb,
+            wsize_,
+            selector_w_,
+            "size_selector_w"));
+        size_selector_w_->allocate();
+
+        model_.reset(new signed_vector<FieldT, M+1>(
+            this->pb,
+            M+1,
+            size_selector_w_,
+            "model"));
+        model_->allocate();
+
+        model_hasher_.reset(new mimc_hash_signed<FieldT, M+1, packing_model>(
+            this->pb,
+            model_,
+            modelHash_,
+            "model_hasher"));
+        model_hasher_->allocate();
+    };
+
+    void generate_r1cs_constraints()
+    {
+        size_selector_w_->generate_r1cs_constraints();
+        model_->generate_r1cs_constraints();
+        model_hasher_->generate_r1cs_constraints();
+    };
+
+    // note that if size of coefficients is less than
+    // M+1, it will be resized in set_values.
+    void generate_r1cs_witness(column_span<double> model_coefficients)
+    {
+        this->pb.val(wsize_) = M+1;
+        size_selector_w_->generate_r1cs_witness();
+        model_->set_values(model_coefficients);
+        model_->generate_r1cs_witness();
+        model_hasher_->generate_r1cs_witness();
+    };
+};
+
 } // namespace
 
 #endif
@@ -0,0 +1,258 @@
+#include <fstream>
+#include <cstring>
+#include <cassert>
+#include <random>
+#include <sys/resource.h>
+
+using namespace libsnark;
+
+namespace TrustedAI {
+
+//! magic string at the start of a binary proving key
+const char binary_proving_key_magic[8] = {'T', 'A', 'I', 'P', 'K', 'B', '0', '1'};
+
+template<typename T>
+void write_raw(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+void read_raw(std::istream& in, T& value)
+{
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+template<typename T>
+void write_raw_vector(std::ostream& out, const std::vector<T>& values)
+{
+    uint64_t n = values.size();
+    write_raw(out, n);
+    out.write(reinterpret_cast<const char*>(values.data()), n * sizeof(T));
+}
+
+/**
+ * Bytes between the read position and the end of the stream,
+ * 0 if the stream cannot seek
+ */
+inline uint64_t remaining_bytes(std::istream& in)
+{
+    const auto pos = in.tellg();
+    if (pos < 0) return 0;
+    in.seekg(0, std::ios::end);
+    const auto end = in.tellg();
+    in.seekg(pos);
+    return (end < pos) ? 0 : uint64_t(end - pos);
+}
+
+// counts are checked against the bytes left before allocating, a
+// malformed key fails the stream instead of exhausting memory
+template<typename T>
+void read_raw_vector(std::istream& in, std::vector<T>& values)
+{
+    uint64_t n = 0;
+    read_raw(in, n);
+    if (!in.good() || n > remaining_bytes(in) / sizeof(T)) {
+        values.clear();
+        in.setstate(std::ios::failbit);
+        return;
+    }
+    values.resize(n);
+    in.read(reinterpret_cast<char*>(values.data()), n * sizeof(T));
+}
+
+template<typename T>
+void write_sparse_vector(std::ostream& out, const sparse_vector<T>& v)
+{
+    uint64_t domain_size = v.domain_size_;
+    write_raw(out, domain_size);
+    write_raw_vector(out, v.indices);
+    write_raw_vector(out, v.values);
+}
+
+template<typename T>
+void read_sparse_vector(std::istream& in, sparse_vector<T>& v)
+{
+    uint64_t domain_size = 0;
+    read_raw(in, domain_size);
+    v.domain_size_ = domain_size;
+    read_raw_vector(in, v.indices);
+    read_raw_vector(in, v.values);
+}
+
+template<typename FieldT>
+void write_linear_combination(std::ostream& out, const linear_combination<FieldT>& lc)
+{
+    uint64_t n = lc.terms.size();
+    write_raw(out, n);
+    for(auto& term : lc.terms) {
+        uint64_t index = term.index;
+        write_raw(out, index);
+        write_raw(out, term.coeff);
+    }
+}
+
+template<typename FieldT>
+void read_linear_combination(std::istream& in, linear_combination<FieldT>& lc)
+{
+    uint64_t n = 0;
+    read_raw(in, n);
+    // read term by term, a wrong count stops at the end of the stream
+    lc.terms.clear();
+    for(size_t i=0; i < n && in.good(); ++i) {
+        uint64_t index = 0;
+        read_raw(in, index);
+        lc.terms.emplace_back();
+        lc.terms.back().index = index;
+        read_raw(in, lc.terms.back().coeff);
+    }
+}
+
+template<typename FieldT>
+void write_constraint_system(std::ostream& out, const r1cs_constraint_system<FieldT>& cs)
+{
+    uint64_t primary_input_size = cs.primary_input_size;
+    uint64_t auxiliary_input_size = cs.auxiliary_input_size;
+    uint64_t num_constraints = cs.constraints.size();
+    write_raw(out, primary_input_size);
+    write_raw(out, auxiliary_input_size);
+    write_raw(out, num_constraints);
+    for(auto& c : cs.constraints) {
+        write_linear_combination(out, c.a);
+        write_linear_combination(out, c.b);
+        write_linear_combination(out, c.c);
+    }
+}
+
+template<typename FieldT>
+void read_constraint_system(std::istream& in, r1cs_constraint_system<FieldT>& cs)
+{
+    uint64_t primary_input_size = 0, auxiliary_input_size = 0, num_constraints = 0;
+    read_raw(in, primary_input_size);
+    read_raw(in, auxiliary_input_size);
+    read_raw(in, num_constraints);
+    cs.primary_input_size = primary_input_size;
+    cs.auxiliary_input_size = auxiliary_input_size;
+    // a constraint holds at least the term counts of a, b and c
+    if (!in.good() || num_constraints > remaining_bytes(in) / (3 * sizeof(uint64_t))) {
+        cs.constraints.clear();
+        in.setstate(std::ios::failbit);
+        return;
+    }
+    cs.constraints.resize(num_constraints);
+    for(size_t i=0; i < num_constraints && in.good(); ++i) {
+        read_linear_combination(in, cs.constraints[i].a);
+        read_linear_combination(in, cs.constraints[i].b);
+        read_linear_combination(in, cs.constraints[i].c);
+    }
+}
+
+inline std::string new_proving_key_id()
+{
+    static const char hex[] = "0123456789abcdef";
+    std::random_device rd;
+    std::string id;
+    while (id.size() < proving_key_id_size) {
+        const uint32_t bits = rd();
+        for(size_t k=0; k < 8 && id.size() < proving_key_id_size; ++k)
+            id += hex[(bits >> (4*k)) & 0xf];
+    }
+    return id;
+}
+
+template<typename ppT>
+bool write_proving_key_binary(
+    std::ostream& out,
+    const r1cs_ppzksnark_proving_key<ppT>& pk,
+    const std::string& key_id)
+{
+    assert(key_id.size() == proving_key_id_size);
+    uint64_t sizes[3] = {
+        sizeof(libff::Fr<ppT>), sizeof(libff::G1<ppT>), sizeof(libff::G2<ppT>)};
+
+    out.write(binary_proving_key_magic, sizeof(binary_proving_key_magic));
+    out.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+    out.write(key_id.data(), proving_key_id_size);
+    write_sparse_vector(out, pk.A_query);
+    write_sparse_vector(out, pk.B_query);
+    write_sparse_vector(out, pk.C_query);
+    write_raw_vector(out, pk.H_query);
+    write_raw_vector(out, pk.K_query);
+    write_constraint_system(out, pk.constraint_system);
+    return out.good();
+}
+
+template<typename ppT>
+bool read_proving_key_binary(
+    std::istream& in,
+    r1cs_ppzksnark_proving_key<ppT>& pk,
+    std::string& key_id)
+{
+    char magic[sizeof(binary_proving_key_magic)];
+    in.read(magic, sizeof(magic));
+    if (!in.good() || std::memcmp(magic, binary_proving_key_magic, sizeof(magic)) != 0)
+        return false;
+
+    uint64_t sizes[3];
+    in.read(reinterpret_cast<char*>(sizes), sizeof(sizes));
+    if ((sizes[0] != sizeof(libff::Fr<ppT>)) ||
+        (sizes[1] != sizeof(libff::G1<ppT>)) ||
+        (sizes[2] != sizeof(libff::G2<ppT>))) {
+        std::cout << "Binary proving key was written for a different curve" << std::endl;
+        return false;
+    }
+    key_id.resize(proving_key_id_size);
+    in.read(&key_id[0], proving_key_id_size);
+
+    read_sparse_vector(in, pk.A_query);
+    read_sparse_vector(in, pk.B_query);
+    read_sparse_vector(in, pk.C_query);
+    read_raw_vector(in, pk.H_query);
+    read_raw_vector(in, pk.K_query);
+    read_constraint_system(in, pk.constraint_system);
+    return !in.fail();
+}
+
+template<typename ppT>
+bool read_proving_key(
+    const std::string& file,
+    r1cs_ppzksnark_proving_key<ppT>& pk,
+    std::string& key_id)
+{
+    std::ifstream in(file, std::ios::binary);
+    if (!in) return false;
+
+    char magic[sizeof(binary_proving_key_magic)] = {0};
+    in.read(magic, sizeof(magic));
+    bool is_binary = in.good() &&
+        (std::memcmp(magic, binary_proving_key_magic, sizeof(magic)) == 0);
+
+    in.clear();
+    in.seekg(0);
+    if (is_binary)
+        return read_proving_key_binary(in, pk, key_id);
+
+    key_id.clear();
+    in >> pk;
+    return !in.fail();
+}
+
+template<typename ppT>
+bool read_proving_key(
+    const std::string& file,
+    r1cs_ppzksnark_proving_key<ppT>& pk)
+{
+    std::string key_id;
+    return read_proving_key(file, pk, key_id);
+}
+
+inline size_t peak_rss_kb()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    // ru_maxrss is reported in KB on linux
+    return usage.ru_maxrss;
+}
+
+} // namespace
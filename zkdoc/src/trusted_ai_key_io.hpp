@@ -0,0 +1,72 @@
+#ifndef __TRUSTED_AI_KEY_IO_HPP__
+#define __TRUSTED_AI_KEY_IO_HPP__
+
+#include <libsnark/zk_proof_systems/ppzksnark/r1cs_ppzksnark/r1cs_ppzksnark.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+using namespace libsnark;
+
+namespace TrustedAI {
+
+/**
+ * Binary serialization of r1cs_ppzksnark proving keys.
+ * The text form (operator<<) prints every coordinate in decimal,
+ * which is slow to parse and needs a second copy of the key when
+ * buffered. The binary form streams each query straight from the
+ * key to the output: group and field elements are written in their
+ * in-memory (Montgomery) layout, so a binary key is only readable
+ * by a build for the same curve. A header records element sizes
+ * so that a mismatch is detected instead of misread, and the id
+ * of the key, which files derived from the key (precomputed
+ * tables) record to be matched without reading the key twice.
+ */
+template<typename ppT>
+bool write_proving_key_binary(
+    std::ostream& out,
+    const r1cs_ppzksnark_proving_key<ppT>& pk,
+    const std::string& key_id);
+
+template<typename ppT>
+bool read_proving_key_binary(
+    std::istream& in,
+    r1cs_ppzksnark_proving_key<ppT>& pk,
+    std::string& key_id);
+
+//! characters of a proving key id
+const size_t proving_key_id_size = 32;
+
+/**
+ * A fresh id for a generated proving key, 128 random bits in hex
+ */
+inline std::string new_proving_key_id();
+
+/**
+ * Reads a proving key from file, in either binary or text form
+ * @input file path to the proving key
+ * @input key_id set to the id of a binary key, "" for a text key
+ * @return false in case of failure
+ */
+template<typename ppT>
+bool read_proving_key(
+    const std::string& file,
+    r1cs_ppzksnark_proving_key<ppT>& pk,
+    std::string& key_id);
+
+template<typename ppT>
+bool read_proving_key(
+    const std::string& file,
+    r1cs_ppzksnark_proving_key<ppT>& pk);
+
+/**
+ * Peak resident set size of this process in KB
+ */
+inline size_t peak_rss_kb();
+
+} // namespace
+
+#include <zkdoc/src/trusted_ai_key_io.cpp>
+
+#endif
@@ -0,0 +1,222 @@
+#include <libff/common/utils.hpp>
+#include <cstdint>
+#include <cassert>
+#ifdef MULTICORE
+#include <omp.h>
+#endif
+
+namespace TrustedAI {
+
+static_assert(sizeof(mp_limb_t) == 8, "mimc_lanes expects 64-bit limbs");
+
+inline bool parse_hash_engine(const std::string& name, hash_engine& engine)
+{
+    if (name == "circuit") {
+        engine = hash_engine::circuit;
+        return true;
+    }
+    if (name == "lanes") {
+        engine = hash_engine::lanes;
+        return true;
+    }
+    return false;
+}
+
+typedef unsigned __int128 mimc_wide_t;
+
+template<typename FieldT, size_t L>
+mimc_lanes<FieldT, L>::mimc_lanes()
+{
+    for(size_t k=0; k < n; ++k)
+        for(size_t l=0; l < L; ++l)
+            input_[k][l] = key_[k][l] = 0;
+}
+
+template<typename FieldT, size_t L>
+void mimc_lanes<FieldT, L>::set_input(size_t lane, const FieldT& input)
+{
+    for(size_t k=0; k < n; ++k)
+        input_[k][lane] = input.mont_repr.data[k];
+}
+
+template<typename FieldT, size_t L>
+void mimc_lanes<FieldT, L>::set_key(size_t lane, const FieldT& key)
+{
+    for(size_t k=0; k < n; ++k)
+        key_[k][lane] = key.mont_repr.data[k];
+}
+
+template<typename FieldT, size_t L>
+FieldT mimc_lanes<FieldT, L>::key(size_t lane) const
+{
+    FieldT key;
+    for(size_t k=0; k < n; ++k)
+        key.mont_repr.data[k] = key_[k][lane];
+    return key;
+}
+
+// r = a + b mod p, for a, b < p
+template<typename FieldT, size_t L>
+void mimc_lanes<FieldT, L>::add(const lanes_t& a, const lanes_t& b, lanes_t& r)
+{
+    const mp_limb_t* p = FieldT::mod.data;
+    for(size_t l=0; l < L; ++l) {
+        mp_limb_t s[n], d[n];
+        mp_limb_t carry = 0, borrow = 0;
+        for(size_t k=0; k < n; ++k) {
+            const mimc_wide_t t = mimc_wide_t(a[k][l]) + b[k][l] + carry;
+            s[k] = mp_limb_t(t);
+            carry = mp_limb_t(t >> 64);
+        }
+        for(size_t k=0; k < n; ++k) {
+            const mimc_wide_t t = mimc_wide_t(s[k]) - p[k] - borrow;
+            d[k] = mp_limb_t(t);
+            borrow = mp_limb_t(t >> 64) & 1;
+        }
+        // s - p underflows iff s < p, unless the sum carried
+        const bool reduce = carry || !borrow;
+        for(size_t k=0; k < n; ++k)
+            r[k][l] = reduce ? d[k] : s[k];
+    }
+}
+
+// r = a * b / R mod p, as Fp_model::mul_reduce
+template<typename FieldT, size_t L>
+void mimc_lanes<FieldT, L>::mul(const lanes_t& a, const lanes_t& b, lanes_t& r)
+{
+    const mp_limb_t* p = FieldT::mod.data;
+    const mp_limb_t inv = FieldT::inv;
+    for(size_t l=0; l < L; ++l) {
+        mp_limb_t t[n+2] = {0};
+        for(size_t i=0; i < n; ++i) {
+            mimc_wide_t w;
+            mp_limb_t carry = 0;
+            for(size_t j=0; j < n; ++j) {
+                w = mimc_wide_t(a[j][l]) * b[i][l] + t[j] + carry;
+                t[j] = mp_limb_t(w);
+                carry = mp_limb_t(w >> 64);
+            }
+            w = mimc_wide_t(t[n]) + carry;
+            t[n] = mp_limb_t(w);
+            t[n+1] = mp_limb_t(w >> 64);
+
+            const mp_limb_t m = t[0] * inv;
+            w = mimc_wide_t(m) * p[0] + t[0];
+            carry = mp_limb_t(w >> 64);
+            for(size_t j=1; j < n; ++j) {
+                w = mimc_wide_t(m) * p[j] + t[j] + carry;
+                t[j-1] = mp_limb_t(w);
+                carry = mp_limb_t(w >> 64);
+            }
+            w = mimc_wide_t(t[n]) + carry;
+            t[n-1] = mp_limb_t(w);
+            t[n] = t[n+1] + mp_limb_t(w >> 64);
+        }
+
+        mp_limb_t d[n], borrow = 0;
+        for(size_t k=0; k < n; ++k) {
+            const mimc_wide_t w = mimc_wide_t(t[k]) - p[k] - borrow;
+            d[k] = mp_limb_t(w);
+            borrow = mp_limb_t(w >> 64) & 1;
+        }
+        const bool reduce = t[n] || !borrow;
+        for(size_t k=0; k < n; ++k)
+            r[k][l] = reduce ? d[k] : t[k];
+    }
+}
+
+template<typename FieldT, size_t L>
+void mimc_lanes<FieldT, L>::chain()
+{
+    // the round constants in Montgomery form, broadcast to the lanes
+    static const std::vector<std::vector<mp_limb_t>> round_constants = [] {
+        std::vector<std::vector<mp_limb_t>> rcs;
+        for(auto& x : mimc_cipher<FieldT>::round_constants())
+            rcs.emplace_back(x.mont_repr.data, x.mont_repr.data + n);
+        return rcs;
+    }();
+
+    lanes_t x, a, a2, a4, a6, rc;
+    for(size_t k=0; k < n; ++k)
+        for(size_t l=0; l < L; ++l)
+            x[k][l] = input_[k][l];
+
+    for(size_t i=0; i < mimc_cipher<FieldT>::ROUNDS; ++i) {
+        for(size_t k=0; k < n; ++k)
+            for(size_t l=0; l < L; ++l)
+                rc[k][l] = round_constants[i][k];
+        add(x, key_, a);
+        add(a, rc, a);
+        mul(a, a, a2);
+        mul(a2, a2, a4);
+        mul(a4, a2, a6);
+        mul(a, a6, x);
+    }
+    add(x, key_, key_);
+}
+
+template<typename FieldT, size_t N, size_t P>
+std::vector<FieldT> mimc_hash_columns(
+    const std::vector<column_span<uint64_t>>& columns,
+    size_t nrows,
+    hash_mode mode)
+{
+    const size_t L = mimc_lane_count;
+    const size_t chunks = libff::div_ceil(N, P);
+    const size_t leaf = (mode == hash_mode::chain) ? chunks : mimc_tree_leaf_chunks;
+    const size_t leaves_per_column = libff::div_ceil(chunks, leaf);
+    const size_t num_chains = columns.size() * leaves_per_column;
+    assert(nrows <= N);
+
+    // lane l of group g hashes the leaf q = g*L + l
+    std::vector<FieldT> leaves(num_chains);
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for(size_t g=0; g < libff::div_ceil(num_chains, L); ++g) {
+        mimc_lanes<FieldT, L> lanes;
+        uint64_t values[P];
+        for(size_t c=0; c < leaf; ++c) {
+            for(size_t l=0; l < L; ++l) {
+                const size_t q = g*L + l;
+                if (q >= num_chains)
+                    break;
+                const auto& column = columns[q / leaves_per_column];
+                const size_t chunk = (q % leaves_per_column) * leaf + c;
+                for(size_t j=0; j < P; ++j)
+                    values[j] = (chunk*P + j < N) ? column.get(chunk*P + j) : 0;
+                lanes.set_input(l, mimc_pack_chunk<FieldT, P>(values, P));
+            }
+            lanes.chain();
+            for(size_t l=0; l < L; ++l) {
+                const size_t q = g*L + l;
+                if (q >= num_chains)
+                    break;
+                const size_t leaf_end = std::min((q % leaves_per_column + 1) * leaf, chunks);
+                if ((q % leaves_per_column) * leaf + c + 1 == leaf_end)
+                    leaves[q] = lanes.key(l);
+            }
+        }
+    }
+
+    // combine pairwise as mimc_hash_column does, and finalize
+    std::vector<FieldT> hashes;
+    const FieldT size = FieldT(libff::bigint<FieldT::num_limbs>(nrows));
+    for(size_t i=0; i < columns.size(); ++i) {
+        std::vector<FieldT> nodes(
+            leaves.begin() + i * leaves_per_column,
+            leaves.begin() + (i+1) * leaves_per_column);
+        while (nodes.size() > 1) {
+            std::vector<FieldT> parents;
+            for(size_t j=0; j+1 < nodes.size(); j += 2)
+                parents.emplace_back(mimc_encrypt(nodes[j+1], nodes[j]));
+            if (nodes.size() % 2 == 1)
+                parents.emplace_back(nodes.back());
+            nodes.swap(parents);
+        }
+        hashes.emplace_back(mimc_encrypt(size, nodes[0]));
+    }
+    return hashes;
+}
+
+} // namespace
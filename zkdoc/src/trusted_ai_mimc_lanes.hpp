@@ -0,0 +1,77 @@
+#ifndef __TRUSTED_AI_MIMC_LANES_HPP__
+#define __TRUSTED_AI_MIMC_LANES_HPP__
+
+#include <zkdoc/src/trusted_ai_gadgets.hpp>
+#include <zkdoc/src/trusted_ai_hash_gadget.hpp>
+#include <vector>
+#include <string>
+
+namespace TrustedAI {
+
+//! how --gen-handle computes the column hashes
+enum class hash_engine {
+    circuit,    // witness of the data_source gadget
+    lanes       // mimc_hash_columns below
+};
+
+/**
+ * Parse an engine name (circuit|lanes)
+ * @return false if the name is unknown
+ */
+inline bool parse_hash_engine(const std::string& name, hash_engine& engine);
+
+//! lanes hashed in lockstep by mimc_hash_columns
+const size_t mimc_lane_count = 8;
+
+/**
+ * Native MiMC over L independent lanes in lockstep, for prime
+ * fields in Montgomery form with 64-bit limbs (libff::Fp_model).
+ * The state is kept in structure-of-arrays layout, limb k of all
+ * the lanes next to each other, and products are Montgomery
+ * multiplications (CIOS) on 64x64->128 bit multiplies. The rounds
+ * of a lane depend on each other, the lanes do not, so interleaving
+ * them keeps the multiplier busy.
+ */
+template<typename FieldT, size_t L>
+class mimc_lanes {
+public:
+    static const size_t n = FieldT::num_limbs;
+    typedef mp_limb_t lanes_t[n][L];
+
+private:
+    lanes_t input_;
+    lanes_t key_;
+
+    static void add(const lanes_t& a, const lanes_t& b, lanes_t& r);
+    static void mul(const lanes_t& a, const lanes_t& b, lanes_t& r);
+
+public:
+    mimc_lanes();
+
+    void set_input(size_t lane, const FieldT& input);
+    void set_key(size_t lane, const FieldT& key);
+    FieldT key(size_t lane) const;
+
+    // key = mimc_encrypt(input, key) in every lane
+    void chain();
+};
+
+/**
+ * Hashes of columns of N values packed P to a chunk, equal to
+ * mimc_column_hasher::hash. The chains of all the columns (whole
+ * columns in chain mode, leaves in tree mode) are hashed
+ * mimc_lane_count at a time, and the groups of lanes in parallel.
+ * @input columns values of the columns, 0 past their end
+ * @input nrows size of the columns, at most N
+ */
+template<typename FieldT, size_t N, size_t P>
+std::vector<FieldT> mimc_hash_columns(
+    const std::vector<column_span<uint64_t>>& columns,
+    size_t nrows,
+    hash_mode mode);
+
+} // namespace
+
+#include <zkdoc/src/trusted_ai_mimc_lanes.cpp>
+
+#endif
@@ -0,0 +1,214 @@
+#include <libff/common/utils.hpp>
+#include <cstdint>
+#include <cassert>
+#ifdef MULTICORE
+#include <omp.h>
+#endif
+
+using namespace libsnark;
+
+namespace TrustedAI {
+
+//! largest window: signed digits of 15 bits fit in int16_t
+const size_t pippenger_max_window = 15;
+
+inline bool parse_msm_engine(const std::string& name, msm_engine& engine)
+{
+    if (name == "libff") {
+        engine = msm_engine::libff;
+        return true;
+    }
+    if (name == "pippenger") {
+        engine = msm_engine::pippenger;
+        return true;
+    }
+    return false;
+}
+
+template<mp_size_t n>
+size_t scalar_digit(const libff::bigint<n>& s, size_t bit_offset, size_t c)
+{
+    const size_t limb = bit_offset / GMP_NUMB_BITS;
+    const size_t shift = bit_offset % GMP_NUMB_BITS;
+    if (limb >= size_t(n)) return 0;
+
+    mp_limb_t v = s.data[limb] >> shift;
+    if ((shift + c > GMP_NUMB_BITS) && (limb + 1 < size_t(n)))
+        v |= s.data[limb+1] << (GMP_NUMB_BITS - shift);
+
+    return v & ((mp_limb_t(1) << c) - 1);
+}
+
+inline size_t pippenger_window(size_t n)
+{
+    // a window costs n additions plus 2^c for the reduction,
+    // so the optimum is close to c = log2(n) - log2(log2(n))
+    if (n < 32) return 3;
+    const size_t lg = libff::log2(n);
+    size_t c = lg - libff::log2(lg);
+    if (c < 2) c = 2;
+    if (c > pippenger_max_window) c = pippenger_max_window;
+    return c;
+}
+
+/**
+ * Signed c-bit recoding of n scalars, num_windows digits each
+ * (term-major), with digits in [-2^{c-1}+1, 2^{c-1}].
+ */
+template<typename FieldT, typename ScalarAt>
+std::vector<int16_t> signed_digits(
+    size_t n,
+    ScalarAt scalar_at,
+    size_t c,
+    size_t num_windows)
+{
+    assert(c <= pippenger_max_window);
+    std::vector<int16_t> digits(n * num_windows);
+    const long half = long(1) << (c - 1);
+
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for(size_t k=0; k < n; ++k) {
+        const auto s = scalar_at(k).as_bigint();
+        long carry = 0;
+        for(size_t j=0; j < num_windows; ++j) {
+            long d = long(scalar_digit(s, j * c, c)) + carry;
+            carry = 0;
+            if (d > half) {
+                d -= (half << 1);
+                carry = 1;
+            }
+            digits[k * num_windows + j] = int16_t(d);
+        }
+        assert(carry == 0);
+    }
+
+    return digits;
+}
+
+/**
+ * Bucket pass of the pippenger method over precomputed digits
+ */
+template<typename GroupT, typename BaseAt>
+GroupT bucket_multi_exp(
+    size_t n,
+    BaseAt base_at,
+    const std::vector<int16_t>& digits,
+    size_t c,
+    size_t num_windows,
+    size_t chunks)
+{
+    if (n == 0) return GroupT::zero();
+    // split terms only as much as needed to give every
+    // thread a task, each chunk pays for its own reduction
+    chunks = libff::div_ceil(chunks == 0 ? 1 : chunks, num_windows);
+    if (chunks > n) chunks = n;
+
+    const size_t num_buckets = size_t(1) << (c - 1);
+    const size_t num_tasks = num_windows * chunks;
+    std::vector<GroupT> partial(num_tasks, GroupT::zero());
+
+#ifdef MULTICORE
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(size_t t=0; t < num_tasks; ++t) {
+        const size_t j = t / chunks;
+        const size_t ch = t % chunks;
+        const size_t lo = (ch * n) / chunks;
+        const size_t hi = ((ch+1) * n) / chunks;
+        std::vector<GroupT> buckets(num_buckets, GroupT::zero());
+
+        for(size_t k=lo; k < hi; ++k) {
+            const int d = digits[k * num_windows + j];
+#ifdef USE_MIXED_ADDITION
+            if (d > 0)
+                buckets[d-1] = buckets[d-1].mixed_add(base_at(k));
+            else if (d < 0)
+                buckets[-d-1] = buckets[-d-1].mixed_add(-base_at(k));
+#else
+            if (d > 0)
+                buckets[d-1] = buckets[d-1] + base_at(k);
+            else if (d < 0)
+                buckets[-d-1] = buckets[-d-1] - base_at(k);
+#endif
+        }
+
+        // sum_d d.buckets[d-1] using running sums
+        GroupT running = GroupT::zero();
+        GroupT acc = GroupT::zero();
+        for(size_t d=num_buckets; d > 0; --d) {
+            running = running + buckets[d-1];
+            acc = acc + running;
+        }
+        partial[t] = acc;
+    }
+
+    // combine windows from the top: acc = 2^c.acc + window_j
+    GroupT result = GroupT::zero();
+    for(size_t j=num_windows; j > 0; --j) {
+        for(size_t b=0; b < c; ++b)
+            result = result.dbl();
+        for(size_t ch=0; ch < chunks; ++ch)
+            result = result + partial[(j-1) * chunks + ch];
+    }
+
+    return result;
+}
+
+template<typename GroupT, typename FieldT>
+GroupT pippenger_multi_exp(
+    typename std::vector<GroupT>::const_iterator bases,
+    typename std::vector<FieldT>::const_iterator scalars,
+    size_t n,
+    size_t chunks)
+{
+    if (n == 0) return GroupT::zero();
+
+    const size_t c = pippenger_window(n);
+    const size_t num_windows = libff::div_ceil(FieldT::size_in_bits() + 1, c);
+    const auto digits = signed_digits<FieldT>(n,
+        [&](size_t k) -> const FieldT& { return scalars[k]; }, c, num_windows);
+
+    return bucket_multi_exp<GroupT>(n,
+        [&](size_t k) -> const GroupT& { return bases[k]; },
+        digits, c, num_windows, chunks);
+}
+
+template<typename T1, typename T2, typename FieldT>
+knowledge_commitment<T1, T2> pippenger_kc_multi_exp(
+    const knowledge_commitment_vector<T1, T2>& vec,
+    size_t min_idx,
+    size_t max_idx,
+    typename std::vector<FieldT>::const_iterator scalars,
+    size_t chunks)
+{
+    // positions of the query entries in range
+    std::vector<size_t> pos;
+    for(size_t i=0; i < vec.indices.size(); ++i) {
+        const size_t idx = vec.indices[i];
+        if ((idx >= min_idx) && (idx < max_idx))
+            pos.emplace_back(i);
+    }
+
+    const size_t n = pos.size();
+    if (n == 0) return knowledge_commitment<T1, T2>::zero();
+
+    // both components share the recoded scalars
+    const size_t c = pippenger_window(n);
+    const size_t num_windows = libff::div_ceil(FieldT::size_in_bits() + 1, c);
+    const auto digits = signed_digits<FieldT>(n,
+        [&](size_t k) -> const FieldT& { return scalars[vec.indices[pos[k]] - min_idx]; },
+        c, num_windows);
+
+    T1 g = bucket_multi_exp<T1>(n,
+        [&](size_t k) -> const T1& { return vec.values[pos[k]].g; },
+        digits, c, num_windows, chunks);
+    T2 h = bucket_multi_exp<T2>(n,
+        [&](size_t k) -> const T2& { return vec.values[pos[k]].h; },
+        digits, c, num_windows, chunks);
+
+    return knowledge_commitment<T1, T2>(g, h);
+}
+
+} // namespace
@@ -0,0 +1,75 @@
+#ifndef __TRUSTED_AI_MULTIEXP_HPP__
+#define __TRUSTED_AI_MULTIEXP_HPP__
+
+#include <libff/algebra/fields/bigint.hpp>
+#include <libsnark/common/data_structures/sparse_vector.hpp>
+#include <libsnark/knowledge_commitment/knowledge_commitment.hpp>
+#include <vector>
+#include <string>
+
+using namespace libsnark;
+
+namespace TrustedAI {
+
+//! multi-exponentiation engine used by the prover
+enum class msm_engine {
+    libff,      // libff::multi_exp as called by libsnark
+    pippenger   // pippenger_multi_exp below
+};
+
+/**
+ * Parse an engine name (libff|pippenger)
+ * @return false if the name is unknown
+ */
+inline bool parse_msm_engine(const std::string& name, msm_engine& engine);
+
+/**
+ * Extract the c-bit digit of a scalar starting at bit_offset
+ */
+template<mp_size_t n>
+size_t scalar_digit(const libff::bigint<n>& s, size_t bit_offset, size_t c);
+
+/**
+ * Window size (in bits) used by pippenger_multi_exp for n terms
+ */
+inline size_t pippenger_window(size_t n);
+
+/**
+ * Variable-base multi-exponentiation sum_k scalars[k].bases[k]
+ * using the bucket method of Pippenger with signed digits:
+ * each scalar is recoded into c-bit digits in
+ * [-2^{c-1}+1, 2^{c-1}], so that a window needs only 2^{c-1}
+ * buckets (a negative digit adds the negated base). The work is
+ * split over (window, chunk of terms) pairs, and every pair
+ * reduces its own buckets with running sums, so both the bucket
+ * accumulation and the bucket reduction run in parallel.
+ * As in libsnark, mixed additions are only used when keys are
+ * generated with USE_MIXED_ADDITION (bases in special form).
+ * @input chunks number of parallel tasks to aim for
+ */
+template<typename GroupT, typename FieldT>
+GroupT pippenger_multi_exp(
+    typename std::vector<GroupT>::const_iterator bases,
+    typename std::vector<FieldT>::const_iterator scalars,
+    size_t n,
+    size_t chunks);
+
+/**
+ * Same as pippenger_multi_exp, over the entries of a sparse
+ * knowledge commitment query whose index lies in
+ * [min_idx, max_idx); entry idx is paired with
+ * scalars[idx - min_idx].
+ */
+template<typename T1, typename T2, typename FieldT>
+knowledge_commitment<T1, T2> pippenger_kc_multi_exp(
+    const knowledge_commitment_vector<T1, T2>& vec,
+    size_t min_idx,
+    size_t max_idx,
+    typename std::vector<FieldT>::const_iterator scalars,
+    size_t chunks);
+
+} // namespace
+
+#include <zkdoc/src/trusted_ai_multiexp.cpp>
+
+#endif
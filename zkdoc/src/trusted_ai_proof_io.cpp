@@ -0,0 +1,273 @@
+#include <sstream>
+#include <cctype>
+#include <cstring>
+
+using namespace libsnark;
+
+namespace TrustedAI {
+
+//! version byte of the binary proof encoding
+const unsigned char binary_proof_version = 1;
+
+const char base64_alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+inline bool parse_proof_format(const std::string& name, proof_format& format)
+{
+    if (name == "binary") {
+        format = proof_format::binary;
+        return true;
+    }
+    if (name == "text") {
+        format = proof_format::text;
+        return true;
+    }
+    return false;
+}
+
+inline std::string base64_encode(const std::string& bytes)
+{
+    std::string out;
+    out.reserve(4 * ((bytes.size() + 2) / 3));
+    size_t i = 0;
+    for(; i + 2 < bytes.size(); i += 3) {
+        uint32_t v = (uint32_t((unsigned char)bytes[i]) << 16) |
+            (uint32_t((unsigned char)bytes[i+1]) << 8) |
+            uint32_t((unsigned char)bytes[i+2]);
+        out.push_back(base64_alphabet[(v >> 18) & 63]);
+        out.push_back(base64_alphabet[(v >> 12) & 63]);
+        out.push_back(base64_alphabet[(v >> 6) & 63]);
+        out.push_back(base64_alphabet[v & 63]);
+    }
+
+    const size_t rest = bytes.size() - i;
+    if (rest > 0) {
+        uint32_t v = uint32_t((unsigned char)bytes[i]) << 16;
+        if (rest == 2)
+            v |= uint32_t((unsigned char)bytes[i+1]) << 8;
+        out.push_back(base64_alphabet[(v >> 18) & 63]);
+        out.push_back(base64_alphabet[(v >> 12) & 63]);
+        out.push_back((rest == 2) ? base64_alphabet[(v >> 6) & 63] : '=');
+        out.push_back('=');
+    }
+    return out;
+}
+
+inline bool base64_decode(const std::string& text, std::string& bytes)
+{
+    bytes.clear();
+    uint32_t v = 0;
+    size_t bits = 0, padding = 0;
+    for(char ch : text) {
+        if (std::isspace((unsigned char)ch)) continue;
+        if (ch == '=') {
+            ++padding;
+            continue;
+        }
+        // no data after padding
+        if (padding > 0) return false;
+
+        const char* p = std::strchr(base64_alphabet, ch);
+        if ((p == nullptr) || (ch == '\0')) return false;
+        v = (v << 6) | uint32_t(p - base64_alphabet);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            bytes.push_back(char((v >> bits) & 0xff));
+        }
+    }
+    return (padding <= 2) && (bits < 6);
+}
+
+/**
+ * Fixed width little endian bytes of the canonical form of x
+ */
+template<typename FieldT>
+void append_field_bytes(std::string& out, const FieldT& x)
+{
+    const size_t nbytes = (FieldT::size_in_bits() + 7) / 8;
+    const auto b = x.as_bigint();
+    for(size_t i=0; i < nbytes; ++i) {
+        const size_t limb = i / sizeof(mp_limb_t);
+        const size_t shift = 8 * (i % sizeof(mp_limb_t));
+        out.push_back(char((b.data[limb] >> shift) & 0xff));
+    }
+}
+
+/**
+ * Inverse of append_field_bytes, rejects values >= modulus
+ */
+template<typename FieldT>
+bool read_field_bytes(const std::string& in, size_t& pos, FieldT& x)
+{
+    const size_t nbytes = (FieldT::size_in_bits() + 7) / 8;
+    if (pos + nbytes > in.size()) return false;
+
+    auto b = FieldT::mod;
+    b.clear();
+    for(size_t i=0; i < nbytes; ++i) {
+        const size_t limb = i / sizeof(mp_limb_t);
+        const size_t shift = 8 * (i % sizeof(mp_limb_t));
+        b.data[limb] |= mp_limb_t((unsigned char)in[pos + i]) << shift;
+    }
+    pos += nbytes;
+
+    if (mpn_cmp(b.data, FieldT::mod.data, FieldT::num_limbs) >= 0)
+        return false;
+    x = FieldT(b);
+    return true;
+}
+
+// Fq3 coordinates are written as (c0, c1, c2)
+inline void append_field_bytes(std::string& out, const libff::edwards_Fq3& x)
+{
+    append_field_bytes(out, x.c0);
+    append_field_bytes(out, x.c1);
+    append_field_bytes(out, x.c2);
+}
+
+inline bool read_field_bytes(const std::string& in, size_t& pos, libff::edwards_Fq3& x)
+{
+    return read_field_bytes(in, pos, x.c0) &&
+        read_field_bytes(in, pos, x.c1) &&
+        read_field_bytes(in, pos, x.c2);
+}
+
+inline bool y_parity(const libff::edwards_Fq& y)
+{
+    return y.as_bigint().data[0] & 1;
+}
+
+inline bool y_parity(const libff::edwards_Fq3& y)
+{
+    return y.c0.as_bigint().data[0] & 1;
+}
+
+/**
+ * Appends the x-coordinate of p, returns the parity of y
+ */
+template<typename GroupT>
+bool compress_point(std::string& out, const GroupT& p)
+{
+    GroupT affine = p;
+    affine.to_affine_coordinates();
+    append_field_bytes(out, affine.X);
+    return y_parity(affine.Y);
+}
+
+// y^2 = (1 - a.x^2)/(1 - d.x^2) on the edwards curve and its twist
+inline libff::edwards_Fq edwards_y_squared(const libff::edwards_Fq& x)
+{
+    const libff::edwards_Fq x2 = x.squared();
+    return (libff::edwards_coeff_a * x2 - libff::edwards_Fq::one()) *
+        (libff::edwards_coeff_d * x2 - libff::edwards_Fq::one()).inverse();
+}
+
+inline libff::edwards_Fq3 edwards_y_squared(const libff::edwards_Fq3& x)
+{
+    const libff::edwards_Fq3 x2 = x.squared();
+    return (libff::edwards_G2::mul_by_a(x2) - libff::edwards_Fq3::one()) *
+        (libff::edwards_G2::mul_by_d(x2) - libff::edwards_Fq3::one()).inverse();
+}
+
+/**
+ * Reads an x-coordinate and recovers the point with the given
+ * parity of y
+ */
+template<typename GroupT, typename CoordT>
+bool decompress_point(const std::string& in, size_t& pos, bool parity, GroupT& p)
+{
+    CoordT x;
+    if (!read_field_bytes(in, pos, x)) return false;
+
+    const CoordT y2 = edwards_y_squared(x);
+    // sqrt() expects a quadratic residue
+    if (!y2.is_zero() && !((y2^CoordT::euler) == CoordT::one()))
+        return false;
+
+    CoordT y = y2.sqrt();
+    if (y_parity(y) != parity)
+        y = -y;
+    if (y_parity(y) != parity)
+        return false;
+
+    p = GroupT(x, y);
+    return p.is_well_formed();
+}
+
+template<typename ppT>
+std::string serialize_proof_binary(const r1cs_ppzksnark_proof<ppT>& proof)
+{
+    std::string points;
+    unsigned char parity = 0;
+    parity |= compress_point(points, proof.g_A.g) << 0;
+    parity |= compress_point(points, proof.g_A.h) << 1;
+    parity |= compress_point(points, proof.g_B.g) << 2;
+    parity |= compress_point(points, proof.g_B.h) << 3;
+    parity |= compress_point(points, proof.g_C.g) << 4;
+    parity |= compress_point(points, proof.g_C.h) << 5;
+    parity |= compress_point(points, proof.g_H) << 6;
+    parity |= compress_point(points, proof.g_K) << 7;
+
+    std::string out;
+    out.push_back(char(binary_proof_version));
+    out.push_back(char(parity));
+    return out + points;
+}
+
+template<typename ppT>
+bool deserialize_proof_binary(const std::string& bytes, r1cs_ppzksnark_proof<ppT>& proof)
+{
+    typedef libff::G1<ppT> G1;
+    typedef libff::G2<ppT> G2;
+    typedef decltype(G1::zero().X) G1_coord;
+    typedef decltype(G2::zero().X) G2_coord;
+
+    if ((bytes.size() < 2) || ((unsigned char)bytes[0] != binary_proof_version))
+        return false;
+
+    const unsigned char parity = bytes[1];
+    size_t pos = 2;
+    bool ok = true;
+    ok = ok && decompress_point<G1, G1_coord>(bytes, pos, parity & 1, proof.g_A.g);
+    ok = ok && decompress_point<G1, G1_coord>(bytes, pos, parity & 2, proof.g_A.h);
+    ok = ok && decompress_point<G2, G2_coord>(bytes, pos, parity & 4, proof.g_B.g);
+    ok = ok && decompress_point<G1, G1_coord>(bytes, pos, parity & 8, proof.g_B.h);
+    ok = ok && decompress_point<G1, G1_coord>(bytes, pos, parity & 16, proof.g_C.g);
+    ok = ok && decompress_point<G1, G1_coord>(bytes, pos, parity & 32, proof.g_C.h);
+    ok = ok && decompress_point<G1, G1_coord>(bytes, pos, parity & 64, proof.g_H);
+    ok = ok && decompress_point<G1, G1_coord>(bytes, pos, parity & 128, proof.g_K);
+    return ok && (pos == bytes.size());
+}
+
+template<typename ppT>
+std::string encode_proof(const r1cs_ppzksnark_proof<ppT>& proof, proof_format format)
+{
+    if (format == proof_format::binary)
+        return base64_encode(serialize_proof_binary(proof));
+
+    std::stringstream proofstr;
+    proofstr << proof;
+    return proofstr.str();
+}
+
+template<typename ppT>
+bool decode_proof(const std::string& text, r1cs_ppzksnark_proof<ppT>& proof)
+{
+    size_t first = 0;
+    while ((first < text.size()) && std::isspace((unsigned char)text[first]))
+        ++first;
+    if (first == text.size()) return false;
+
+    if (std::isdigit((unsigned char)text[first])) {
+        std::stringstream proofstr(text);
+        proofstr >> proof;
+        return !proofstr.fail();
+    }
+
+    std::string bytes;
+    if (!base64_decode(text, bytes)) return false;
+    return deserialize_proof_binary(bytes, proof);
+}
+
+} // namespace
@@ -0,0 +1,68 @@
+#ifndef __TRUSTED_AI_PROOF_IO_HPP__
+#define __TRUSTED_AI_PROOF_IO_HPP__
+
+#include <libsnark/zk_proof_systems/ppzksnark/r1cs_ppzksnark/r1cs_ppzksnark.hpp>
+#include <libff/algebra/curves/edwards/edwards_pp.hpp>
+#include <string>
+
+using namespace libsnark;
+
+namespace TrustedAI {
+
+//! format of the proofs written by the prove commands
+enum class proof_format {
+    binary,     // compressed points, base64 encoded
+    text        // libsnark operator<<
+};
+
+/**
+ * Parse a proof format name (binary|text)
+ * @return false if the name is unknown
+ */
+inline bool parse_proof_format(const std::string& name, proof_format& format);
+
+/**
+ * Standard base64 (RFC 4648) with padding
+ */
+inline std::string base64_encode(const std::string& bytes);
+
+/**
+ * Decodes base64, ignoring whitespace
+ * @return false on malformed input
+ */
+inline bool base64_decode(const std::string& text, std::string& bytes);
+
+/**
+ * Compact serialization of an r1cs_ppzksnark proof: a version
+ * byte, a byte with the y-parity of the eight points, and the
+ * canonical x-coordinate of each point (little endian, fixed
+ * width). Points are decompressed from the curve equation on
+ * read; coordinates outside the field or off the curve are
+ * rejected.
+ */
+template<typename ppT>
+std::string serialize_proof_binary(const r1cs_ppzksnark_proof<ppT>& proof);
+
+template<typename ppT>
+bool deserialize_proof_binary(const std::string& bytes, r1cs_ppzksnark_proof<ppT>& proof);
+
+/**
+ * Proof as stored in the YAML outputs, in the given format
+ */
+template<typename ppT>
+std::string encode_proof(const r1cs_ppzksnark_proof<ppT>& proof, proof_format format);
+
+/**
+ * Reads a proof written by encode_proof in either format.
+ * The legacy text form starts with a decimal coordinate,
+ * anything else is taken as base64.
+ * @return false if the proof cannot be parsed
+ */
+template<typename ppT>
+bool decode_proof(const std::string& text, r1cs_ppzksnark_proof<ppT>& proof);
+
+} // namespace
+
+#include <zkdoc/src/trusted_ai_proof_io.cpp>
+
+#endif
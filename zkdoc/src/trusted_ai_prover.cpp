@@ -0,0 +1,480 @@
+#include <fstream>
+#include <cstring>
+#include <numeric>
+#include <cassert>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef MULTICORE
+#include <omp.h>
+#endif
+
+using namespace libsnark;
+
+namespace TrustedAI {
+
+//! magic string at the start of a precomputed key file
+const char precomputed_key_magic[8] = {'T', 'A', 'I', 'P', 'P', 'K', '0', '2'};
+
+template<typename GroupT>
+template<typename FieldT>
+void fixed_base_table<GroupT>::build(
+    const std::vector<GroupT>& bases,
+    const std::vector<size_t>& indices,
+    size_t window)
+{
+    assert(bases.size() == indices.size());
+    window_ = window;
+    num_windows_ = libff::div_ceil(FieldT::size_in_bits(), window);
+
+    // zero bases do not contribute to the sum, drop them
+    std::vector<GroupT> nonzero;
+    own_indices_.clear();
+    for(size_t k=0; k < bases.size(); ++k) {
+        if (bases[k].is_zero()) continue;
+        own_indices_.emplace_back(indices[k]);
+        nonzero.emplace_back(bases[k]);
+    }
+    num_bases_ = own_indices_.size();
+
+    // table[k][j] = 2^{c.j}.P_k
+    own_points_.resize(num_bases_ * num_windows_);
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for(size_t k=0; k < num_bases_; ++k) {
+        GroupT p = nonzero[k];
+        for(size_t j=0; j < num_windows_; ++j) {
+            own_points_[k*num_windows_ + j] = p;
+            for(size_t b=0; b < window_; ++b)
+                p = p.dbl();
+        }
+    }
+
+    // affine form so that the prover can use mixed additions
+    GroupT::batch_to_special_all_non_zeros(own_points_);
+
+    indices_ = own_indices_.data();
+    points_ = own_points_.data();
+}
+
+template<typename GroupT>
+size_t fixed_base_table<GroupT>::size_in_bytes() const
+{
+    return 4 * sizeof(uint64_t) +
+        num_bases_ * sizeof(uint64_t) +
+        num_bases_ * num_windows_ * sizeof(GroupT);
+}
+
+template<typename GroupT>
+void fixed_base_table<GroupT>::write(std::ostream& out) const
+{
+    // group elements are written in their in-memory form
+    // (plain coordinates in Montgomery representation), so
+    // that a mapped table can be used without deserialization
+    uint64_t header[4] = {window_, num_windows_, num_bases_, sizeof(GroupT)};
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(indices_), num_bases_ * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(points_), num_bases_ * num_windows_ * sizeof(GroupT));
+}
+
+template<typename GroupT>
+size_t fixed_base_table<GroupT>::attach(const char* region, size_t len)
+{
+    uint64_t header[4];
+    if (len < sizeof(header)) return 0;
+    std::memcpy(header, region, sizeof(header));
+    if (header[3] != sizeof(GroupT)) {
+        std::cout << "Precomputed table built for a different group" << std::endl;
+        return 0;
+    }
+
+    window_ = header[0];
+    num_windows_ = header[1];
+    num_bases_ = header[2];
+    if (len < size_in_bytes()) return 0;
+
+    own_indices_.clear();
+    own_points_.clear();
+    indices_ = reinterpret_cast<const uint64_t*>(region + sizeof(header));
+    points_ = reinterpret_cast<const GroupT*>(region + sizeof(header) + num_bases_ * sizeof(uint64_t));
+    return size_in_bytes();
+}
+
+template<typename GroupT>
+template<typename FieldT>
+GroupT fixed_base_table<GroupT>::multi_exp(
+    const std::vector<FieldT>& scalars,
+    size_t offset,
+    size_t min_idx,
+    size_t max_idx,
+    size_t chunks) const
+{
+    if (num_bases_ == 0) return GroupT::zero();
+    if (chunks == 0) chunks = 1;
+
+    const size_t num_buckets = (size_t(1) << window_) - 1;
+    std::vector<GroupT> partial(chunks, GroupT::zero());
+
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for(size_t t=0; t < chunks; ++t) {
+        const size_t lo = (t * num_bases_) / chunks;
+        const size_t hi = ((t+1) * num_bases_) / chunks;
+        std::vector<GroupT> buckets(num_buckets, GroupT::zero());
+
+        for(size_t k=lo; k < hi; ++k) {
+            const size_t idx = indices_[k];
+            if ((idx < min_idx) || (idx >= max_idx)) continue;
+
+            const auto s = scalars[idx - offset].as_bigint();
+            const GroupT* row = points_ + k * num_windows_;
+            for(size_t j=0; j < num_windows_; ++j) {
+                size_t d = scalar_digit(s, j * window_, window_);
+                if (d == 0) continue;
+                buckets[d-1] = buckets[d-1].mixed_add(row[j]);
+            }
+        }
+
+        // sum_d d.buckets[d-1] using running sums
+        GroupT running = GroupT::zero();
+        GroupT acc = GroupT::zero();
+        for(size_t d=num_buckets; d > 0; --d) {
+            running = running + buckets[d-1];
+            acc = acc + running;
+        }
+        partial[t] = acc;
+    }
+
+    GroupT result = GroupT::zero();
+    for(size_t t=0; t < chunks; ++t)
+        result = result + partial[t];
+
+    return result;
+}
+
+template<typename ppT>
+r1cs_ppzksnark_precomputed_key<ppT>::~r1cs_ppzksnark_precomputed_key()
+{
+    if (region_ != nullptr)
+        munmap(region_, region_len_);
+}
+
+template<typename ppT>
+std::vector<uint64_t> r1cs_ppzksnark_precomputed_key<ppT>::query_sizes(
+    const r1cs_ppzksnark_proving_key<ppT>& pk)
+{
+    return {pk.A_query.values.size(), pk.B_query.values.size(),
+        pk.C_query.values.size(), pk.H_query.size(), pk.K_query.size()};
+}
+
+template<typename ppT>
+void r1cs_ppzksnark_precomputed_key<ppT>::build(
+    const r1cs_ppzksnark_proving_key<ppT>& pk,
+    size_t window,
+    const std::string& key_id)
+{
+    typedef libff::Fr<ppT> FieldT;
+    assert(key_id.size() == proving_key_id_size);
+    window_ = window;
+    query_sizes_ = query_sizes(pk);
+    key_id_ = key_id;
+
+    // knowledge commitment queries are sparse, and contribute
+    // tables for both the g and h components
+    {
+        std::vector<G1> g, h;
+        for(auto& v : pk.A_query.values) {
+            g.emplace_back(v.g);
+            h.emplace_back(v.h);
+        }
+        A_g_.template build<FieldT>(g, pk.A_query.indices, window);
+        A_h_.template build<FieldT>(h, pk.A_query.indices, window);
+    }
+
+    {
+        std::vector<G2> g;
+        std::vector<G1> h;
+        for(auto& v : pk.B_query.values) {
+            g.emplace_back(v.g);
+            h.emplace_back(v.h);
+        }
+        B_g_.template build<FieldT>(g, pk.B_query.indices, window);
+        B_h_.template build<FieldT>(h, pk.B_query.indices, window);
+    }
+
+    {
+        std::vector<G1> g, h;
+        for(auto& v : pk.C_query.values) {
+            g.emplace_back(v.g);
+            h.emplace_back(v.h);
+        }
+        C_g_.template build<FieldT>(g, pk.C_query.indices, window);
+        C_h_.template build<FieldT>(h, pk.C_query.indices, window);
+    }
+
+    std::vector<size_t> dense(pk.H_query.size());
+    std::iota(dense.begin(), dense.end(), 0);
+    H_.template build<FieldT>(pk.H_query, dense, window);
+
+    dense.resize(pk.K_query.size());
+    std::iota(dense.begin(), dense.end(), 0);
+    K_.template build<FieldT>(pk.K_query, dense, window);
+}
+
+template<typename ppT>
+bool r1cs_ppzksnark_precomputed_key<ppT>::write(const std::string& file) const
+{
+    std::ofstream out(file, std::ios::binary);
+    if (!out) return false;
+
+    // header: magic, window, query sizes, id of the proving key,
+    // which keeps the tables 8-byte aligned
+    uint64_t window = window_;
+    out.write(precomputed_key_magic, sizeof(precomputed_key_magic));
+    out.write(reinterpret_cast<const char*>(&window), sizeof(window));
+    out.write(reinterpret_cast<const char*>(query_sizes_.data()), query_sizes_.size() * sizeof(uint64_t));
+    out.write(key_id_.data(), proving_key_id_size);
+    A_g_.write(out);
+    A_h_.write(out);
+    B_g_.write(out);
+    B_h_.write(out);
+    C_g_.write(out);
+    C_h_.write(out);
+    H_.write(out);
+    K_.write(out);
+    out.close();
+    return !out.fail();
+}
+
+template<typename ppT>
+bool r1cs_ppzksnark_precomputed_key<ppT>::load(
+    const std::string& file,
+    const r1cs_ppzksnark_proving_key<ppT>& pk,
+    const std::string& key_id)
+{
+    const std::vector<uint64_t> sizes = query_sizes(pk);
+    const size_t header_size = sizeof(precomputed_key_magic) + sizeof(uint64_t) +
+        sizes.size() * sizeof(uint64_t) + proving_key_id_size;
+
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (size_t(st.st_size) < header_size)) {
+        close(fd);
+        return false;
+    }
+
+    void* region = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) return false;
+
+    const char* ptr = static_cast<const char*>(region);
+    size_t len = st.st_size;
+    if (std::memcmp(ptr, precomputed_key_magic, sizeof(precomputed_key_magic)) != 0) {
+        std::cout << "Not a precomputed key file: " << file << std::endl;
+        munmap(region, len);
+        return false;
+    }
+
+    uint64_t window;
+    std::memcpy(&window, ptr + sizeof(precomputed_key_magic), sizeof(window));
+    size_t pos = sizeof(precomputed_key_magic) + sizeof(window);
+
+    std::vector<uint64_t> file_sizes(sizes.size());
+    std::memcpy(file_sizes.data(), ptr + pos, sizes.size() * sizeof(uint64_t));
+    pos += sizes.size() * sizeof(uint64_t);
+    if (file_sizes != sizes || key_id.size() != proving_key_id_size ||
+        std::memcmp(ptr + pos, key_id.data(), proving_key_id_size) != 0) {
+        std::cout << "Precomputed key " << file << " was built from another proving key, "
+            << "run --precompute-key again" << std::endl;
+        munmap(region, len);
+        return false;
+    }
+    pos += proving_key_id_size;
+
+    size_t used = 0;
+    bool ok = true;
+    ok = ok && (used = A_g_.attach(ptr + pos, len - pos)) != 0; pos += used;
+    ok = ok && (used = A_h_.attach(ptr + pos, len - pos)) != 0; pos += used;
+    ok = ok && (used = B_g_.attach(ptr + pos, len - pos)) != 0; pos += used;
+    ok = ok && (used = B_h_.attach(ptr + pos, len - pos)) != 0; pos += used;
+    ok = ok && (used = C_g_.attach(ptr + pos, len - pos)) != 0; pos += used;
+    ok = ok && (used = C_h_.attach(ptr + pos, len - pos)) != 0; pos += used;
+    ok = ok && (used = H_.attach(ptr + pos, len - pos)) != 0; pos += used;
+    ok = ok && (used = K_.attach(ptr + pos, len - pos)) != 0; pos += used;
+
+    if (!ok) {
+        std::cout << "Truncated precomputed key file: " << file << std::endl;
+        munmap(region, len);
+        return false;
+    }
+
+    if (region_ != nullptr)
+        munmap(region_, region_len_);
+    region_ = region;
+    region_len_ = len;
+    window_ = window;
+    query_sizes_ = sizes;
+    key_id_ = key_id;
+    return true;
+}
+
+template<typename ppT>
+r1cs_ppzksnark_proof<ppT> r1cs_ppzksnark_prover_precomputed(
+    const r1cs_ppzksnark_proving_key<ppT>& pk,
+    const r1cs_ppzksnark_precomputed_key<ppT>& ppk,
+    const r1cs_ppzksnark_primary_input<ppT>& primary_input,
+    const r1cs_ppzksnark_auxiliary_input<ppT>& auxiliary_input)
+{
+    typedef libff::Fr<ppT> FieldT;
+    typedef libff::G1<ppT> G1;
+    typedef libff::G2<ppT> G2;
+
+    libff::enter_block("Call to r1cs_ppzksnark_prover_precomputed");
+
+    const FieldT d1 = FieldT::random_element(),
+        d2 = FieldT::random_element(),
+        d3 = FieldT::random_element();
+
+    libff::enter_block("Compute the polynomial H");
+    const qap_witness<FieldT> qap_wit = r1cs_to_qap_witness_map(
+        pk.constraint_system, primary_input, auxiliary_input, d1, d2, d3);
+    libff::leave_block("Compute the polynomial H");
+
+    const size_t num_vars = qap_wit.num_variables();
+    knowledge_commitment<G1, G1> g_A = pk.A_query[0] + qap_wit.d1*pk.A_query[num_vars+1];
+    knowledge_commitment<G2, G1> g_B = pk.B_query[0] + qap_wit.d2*pk.B_query[num_vars+1];
+    knowledge_commitment<G1, G1> g_C = pk.C_query[0] + qap_wit.d3*pk.C_query[num_vars+1];
+
+    G1 g_H = G1::zero();
+    G1 g_K = (pk.K_query[0] +
+        qap_wit.d1*pk.K_query[num_vars+1] +
+        qap_wit.d2*pk.K_query[num_vars+2] +
+        qap_wit.d3*pk.K_query[num_vars+3]);
+
+#ifdef MULTICORE
+    const size_t chunks = omp_get_max_threads();
+#else
+    const size_t chunks = 1;
+#endif
+
+    const std::vector<FieldT>& abc = qap_wit.coefficients_for_ABCs;
+
+    libff::enter_block("Compute the proof");
+
+    libff::enter_block("Compute answer to A-query", false);
+    g_A = g_A + knowledge_commitment<G1, G1>(
+        ppk.A_g_.multi_exp(abc, 1, 1, 1+num_vars, chunks),
+        ppk.A_h_.multi_exp(abc, 1, 1, 1+num_vars, chunks));
+    libff::leave_block("Compute answer to A-query", false);
+
+    libff::enter_block("Compute answer to B-query", false);
+    g_B = g_B + knowledge_commitment<G2, G1>(
+        ppk.B_g_.multi_exp(abc, 1, 1, 1+num_vars, chunks),
+        ppk.B_h_.multi_exp(abc, 1, 1, 1+num_vars, chunks));
+    libff::leave_block("Compute answer to B-query", false);
+
+    libff::enter_block("Compute answer to C-query", false);
+    g_C = g_C + knowledge_commitment<G1, G1>(
+        ppk.C_g_.multi_exp(abc, 1, 1, 1+num_vars, chunks),
+        ppk.C_h_.multi_exp(abc, 1, 1, 1+num_vars, chunks));
+    libff::leave_block("Compute answer to C-query", false);
+
+    libff::enter_block("Compute answer to H-query", false);
+    g_H = g_H + ppk.H_.multi_exp(qap_wit.coefficients_for_H, 0, 0, qap_wit.degree()+1, chunks);
+    libff::leave_block("Compute answer to H-query", false);
+
+    libff::enter_block("Compute answer to K-query", false);
+    g_K = g_K + ppk.K_.multi_exp(abc, 1, 1, 1+num_vars, chunks);
+    libff::leave_block("Compute answer to K-query", false);
+
+    libff::leave_block("Compute the proof");
+
+    libff::leave_block("Call to r1cs_ppzksnark_prover_precomputed");
+
+    r1cs_ppzksnark_proof<ppT> proof = r1cs_ppzksnark_proof<ppT>(
+        std::move(g_A), std::move(g_B), std::move(g_C), std::move(g_H), std::move(g_K));
+    return proof;
+}
+
+template<typename ppT>
+r1cs_ppzksnark_proof<ppT> r1cs_ppzksnark_prover_pippenger(
+    const r1cs_ppzksnark_proving_key<ppT>& pk,
+    const r1cs_ppzksnark_primary_input<ppT>& primary_input,
+    const r1cs_ppzksnark_auxiliary_input<ppT>& auxiliary_input)
+{
+    typedef libff::Fr<ppT> FieldT;
+    typedef libff::G1<ppT> G1;
+    typedef libff::G2<ppT> G2;
+
+    libff::enter_block("Call to r1cs_ppzksnark_prover_pippenger");
+
+    const FieldT d1 = FieldT::random_element(),
+        d2 = FieldT::random_element(),
+        d3 = FieldT::random_element();
+
+    libff::enter_block("Compute the polynomial H");
+    const qap_witness<FieldT> qap_wit = r1cs_to_qap_witness_map(
+        pk.constraint_system, primary_input, auxiliary_input, d1, d2, d3);
+    libff::leave_block("Compute the polynomial H");
+
+    const size_t num_vars = qap_wit.num_variables();
+    knowledge_commitment<G1, G1> g_A = pk.A_query[0] + qap_wit.d1*pk.A_query[num_vars+1];
+    knowledge_commitment<G2, G1> g_B = pk.B_query[0] + qap_wit.d2*pk.B_query[num_vars+1];
+    knowledge_commitment<G1, G1> g_C = pk.C_query[0] + qap_wit.d3*pk.C_query[num_vars+1];
+
+    G1 g_H = G1::zero();
+    G1 g_K = (pk.K_query[0] +
+        qap_wit.d1*pk.K_query[num_vars+1] +
+        qap_wit.d2*pk.K_query[num_vars+2] +
+        qap_wit.d3*pk.K_query[num_vars+3]);
+
+#ifdef MULTICORE
+    const size_t chunks = omp_get_max_threads();
+#else
+    const size_t chunks = 1;
+#endif
+
+    const std::vector<FieldT>& abc = qap_wit.coefficients_for_ABCs;
+
+    libff::enter_block("Compute the proof");
+
+    libff::enter_block("Compute answer to A-query", false);
+    g_A = g_A + pippenger_kc_multi_exp<G1, G1, FieldT>(
+        pk.A_query, 1, 1+num_vars, abc.begin(), chunks);
+    libff::leave_block("Compute answer to A-query", false);
+
+    libff::enter_block("Compute answer to B-query", false);
+    g_B = g_B + pippenger_kc_multi_exp<G2, G1, FieldT>(
+        pk.B_query, 1, 1+num_vars, abc.begin(), chunks);
+    libff::leave_block("Compute answer to B-query", false);
+
+    libff::enter_block("Compute answer to C-query", false);
+    g_C = g_C + pippenger_kc_multi_exp<G1, G1, FieldT>(
+        pk.C_query, 1, 1+num_vars, abc.begin(), chunks);
+    libff::leave_block("Compute answer to C-query", false);
+
+    libff::enter_block("Compute answer to H-query", false);
+    g_H = g_H + pippenger_multi_exp<G1, FieldT>(
+        pk.H_query.begin(), qap_wit.coefficients_for_H.begin(), qap_wit.degree()+1, chunks);
+    libff::leave_block("Compute answer to H-query", false);
+
+    libff::enter_block("Compute answer to K-query", false);
+    g_K = g_K + pippenger_multi_exp<G1, FieldT>(
+        pk.K_query.begin()+1, abc.begin(), num_vars, chunks);
+    libff::leave_block("Compute answer to K-query", false);
+
+    libff::leave_block("Compute the proof");
+
+    libff::leave_block("Call to r1cs_ppzksnark_prover_pippenger");
+
+    r1cs_ppzksnark_proof<ppT> proof = r1cs_ppzksnark_proof<ppT>(
+        std::move(g_A), std::move(g_B), std::move(g_C), std::move(g_H), std::move(g_K));
+    return proof;
+}
+
+} // namespace
@@ -0,0 +1,150 @@
+#ifndef __TRUSTED_AI_PROVER_HPP__
+#define __TRUSTED_AI_PROVER_HPP__
+
+#include <libsnark/zk_proof_systems/ppzksnark/r1cs_ppzksnark/r1cs_ppzksnark.hpp>
+#include <libsnark/reductions/r1cs_to_qap/r1cs_to_qap.hpp>
+#include <zkdoc/src/trusted_ai_multiexp.hpp>
+#include <zkdoc/src/trusted_ai_key_io.hpp>
+#include <vector>
+#include <memory>
+#include <string>
+#include <iostream>
+
+using namespace libsnark;
+
+namespace TrustedAI {
+
+//! default window size (in bits) for fixed-base tables
+const size_t fixed_base_window = 16;
+
+/**
+ * Precomputed table for a fixed-base multi-exponentiation
+ * sum_i s_i.P_i where the bases P_i come from the proving key.
+ * For every base we store the multiples 2^{c.j}.P_i for
+ * j < ceil(|Fr|/c), so that a multi-exponentiation is a single
+ * bucket pass over the c-bit digits of the scalars, without any
+ * doublings. The table either owns its storage (after build) or
+ * points into a memory mapped key file (after attach).
+ */
+template<typename GroupT>
+class fixed_base_table {
+public:
+    size_t window_;
+    size_t num_windows_;
+    size_t num_bases_;
+    // index of each base in the query it was built from
+    const uint64_t* indices_;
+    // num_bases_ x num_windows_ points, base-major
+    const GroupT* points_;
+
+private:
+    std::vector<uint64_t> own_indices_;
+    std::vector<GroupT> own_points_;
+
+public:
+    fixed_base_table():
+        window_(0), num_windows_(0), num_bases_(0),
+        indices_(nullptr), points_(nullptr) {};
+
+    // builds the table for bases[k] located at indices[k]
+    template<typename FieldT>
+    void build(
+        const std::vector<GroupT>& bases,
+        const std::vector<size_t>& indices,
+        size_t window);
+
+    // serialized size in bytes, a multiple of 8
+    size_t size_in_bytes() const;
+    void write(std::ostream& out) const;
+    // points the table into a region produced by write()
+    // returns the number of bytes consumed, 0 on failure
+    size_t attach(const char* region, size_t len);
+
+    // computes sum scalars[idx - offset].P_idx over all bases
+    // whose index idx lies in [min_idx, max_idx)
+    template<typename FieldT>
+    GroupT multi_exp(
+        const std::vector<FieldT>& scalars,
+        size_t offset,
+        size_t min_idx,
+        size_t max_idx,
+        size_t chunks) const;
+};
+
+
+/**
+ * Extension of the r1cs_ppzksnark proving key with fixed-base
+ * tables for every multi-exponentiation of the prover (A, B, C,
+ * H and K queries). The key is written once by --precompute-key
+ * and memory mapped read-only by the provers, so that concurrent
+ * provers on a machine share the page cache. The header records
+ * the query sizes and the id of the proving key the tables were
+ * built from (see new_proving_key_id), so that tables of a
+ * regenerated key are not used.
+ */
+template<typename ppT>
+class r1cs_ppzksnark_precomputed_key {
+public:
+    typedef libff::G1<ppT> G1;
+    typedef libff::G2<ppT> G2;
+
+    size_t window_;
+    // A, B, C, H and K query sizes of the proving key
+    std::vector<uint64_t> query_sizes_;
+    // id of the proving key, as given to build
+    std::string key_id_;
+    fixed_base_table<G1> A_g_, A_h_;
+    fixed_base_table<G2> B_g_;
+    fixed_base_table<G1> B_h_;
+    fixed_base_table<G1> C_g_, C_h_;
+    fixed_base_table<G1> H_, K_;
+
+private:
+    void* region_;
+    size_t region_len_;
+
+public:
+    r1cs_ppzksnark_precomputed_key(): window_(0), region_(nullptr), region_len_(0) {};
+    r1cs_ppzksnark_precomputed_key(const r1cs_ppzksnark_precomputed_key&) = delete;
+    r1cs_ppzksnark_precomputed_key& operator=(const r1cs_ppzksnark_precomputed_key&) = delete;
+    ~r1cs_ppzksnark_precomputed_key();
+
+    static std::vector<uint64_t> query_sizes(const r1cs_ppzksnark_proving_key<ppT>& pk);
+
+    // @input key_id id of the proving key, proving_key_id_size characters
+    void build(const r1cs_ppzksnark_proving_key<ppT>& pk, size_t window, const std::string& key_id);
+    bool write(const std::string& file) const;
+    // @return false if the file cannot be read, or was built from
+    // a proving key other than pk with id key_id
+    bool load(
+        const std::string& file,
+        const r1cs_ppzksnark_proving_key<ppT>& pk,
+        const std::string& key_id);
+};
+
+/**
+ * Same as r1cs_ppzksnark_prover, but all multi-exponentiations
+ * are answered from the precomputed tables in ppk.
+ */
+template<typename ppT>
+r1cs_ppzksnark_proof<ppT> r1cs_ppzksnark_prover_precomputed(
+    const r1cs_ppzksnark_proving_key<ppT>& pk,
+    const r1cs_ppzksnark_precomputed_key<ppT>& ppk,
+    const r1cs_ppzksnark_primary_input<ppT>& primary_input,
+    const r1cs_ppzksnark_auxiliary_input<ppT>& auxiliary_input);
+
+/**
+ * Same as r1cs_ppzksnark_prover, but all multi-exponentiations
+ * use pippenger_multi_exp instead of libff::multi_exp.
+ */
+template<typename ppT>
+r1cs_ppzksnark_proof<ppT> r1cs_ppzksnark_prover_pippenger(
+    const r1cs_ppzksnark_proving_key<ppT>& pk,
+    const r1cs_ppzksnark_primary_input<ppT>& primary_input,
+    const r1cs_ppzksnark_auxiliary_input<ppT>& auxiliary_input);
+
+} // namespace
+
+#include <zkdoc/src/trusted_ai_prover.cpp>
+
+#endif
@@ -112,7 +112,7 @@ integer_vector<FieldT, N>::get_pb_vals()
 
 template<typename FieldT, size_t N>
 void integer_vector<FieldT, N>::set_values(
-    const std::vector<uint64_t>& values)
+    column_span<uint64_t> values)
 {
     this->contents_->set_values(values);
 }
@@ -179,7 +179,7 @@ categorical_vector<FieldT, N>::get_pb_vals()
 
 template<typename FieldT, size_t N>
 void categorical_vector<FieldT, N>::set_values(
-    const std::vector<uint64_t>& values)
+    column_span<uint64_t> values)
 {
     this->contents_->set_values(values);
 }
@@ -272,7 +272,7 @@ signed_vector<FieldT, N>::get_pb_vals_signs()
 
 template<typename FieldT, size_t N>
 void signed_vector<FieldT, N>::set_values(
-    const std::vector<double>& values)
+    column_span<double> values)
 {
     this->contents_->set_values(values);
 }
@@ -85,7 +85,6 @@ public:
 template<typename FieldT, size_t N>
 class integer_vector : public gadget<FieldT> {
 public:
-    std::vector<uint64_t> values_;
     // integer variables array for vector contents
     std::shared_ptr<integer_variable_array<FieldT> > contents_;
     // pointer to selector gadget
@@ -104,7 +103,7 @@ public:
 
     std::vector<pb_variable<FieldT> > get_pb_vals();
 
-    void set_values(const std::vector<uint64_t>& values);
+    void set_values(column_span<uint64_t> values);
     void allocate();
     void generate_r1cs_constraints(bool enforce_bound=true);
     void generate_r1cs_witness();
@@ -128,7 +127,7 @@ public:
 
     std::vector<pb_variable<FieldT> > get_pb_vals();
     
-    void set_values(const std::vector<uint64_t>& values);
+    void set_values(column_span<uint64_t> values);
     void allocate();
     void generate_r1cs_constraints(bool enforce_bound=true);
     void generate_r1cs_witness();
@@ -154,7 +153,7 @@ public:
     std::vector<pb_variable<FieldT> > get_pb_vals_prec();
     std::vector<pb_variable<FieldT> > get_pb_vals_signs();
 
-    void set_values(const std::vector<double>& values);
+    void set_values(column_span<double> values);
     void set_values(const std::vector<safe_tuple_t>& values);
     void allocate();
     void generate_r1cs_constraints(bool enforce_bound=true);
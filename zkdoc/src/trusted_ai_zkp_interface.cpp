@@ -4,9 +4,18 @@
 #include <zkdoc/src/trusted_ai_datasource.hpp>
 #include <zkdoc/src/trusted_ai_linear_regression.hpp>
 #include <zkdoc/src/trusted_ai_hash_gadget.hpp>
+#include <zkdoc/src/trusted_ai_mimc_lanes.hpp>
 #include <zkdoc/src/trusted_ai_interface_gadgets.hpp>
+#include <zkdoc/src/trusted_ai_prover.hpp>
+#include <zkdoc/src/trusted_ai_key_io.hpp>
+#include <zkdoc/src/trusted_ai_proof_io.hpp>
+#include <zkdoc/src/trusted_ai_csv.hpp>
+#include <zkdoc/src/trusted_ai_binary_io.hpp>
+#include <zkdoc/src/trusted_ai_encoder.hpp>
+#include <zkdoc/src/trusted_ai_arrow.hpp>
+#include <zkdoc/src/trusted_ai_cache.hpp>
 #include <libsnark/zk_proof_systems/ppzksnark/r1cs_ppzksnark/r1cs_ppzksnark.hpp>
-#include <depends/rapidcsv/src/rapidcsv.h>
+#include <libfqfft/evaluation_domain/get_evaluation_domain.hpp>
 #include <yaml-cpp/yaml.h>
 #include <iostream>
 #include <cassert>
@@ -15,10 +24,16 @@
 #include <algorithm>
 #include <tuple>
 #include <set>
+#include <random>
 #include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <gmp.h>
 #include <gmpxx.h>
 #include <getopt.h>
+#ifdef MULTICORE
+#include <omp.h>
+#endif
 
 using namespace TrustedAI;
 using namespace libsnark;
@@ -27,10 +42,32 @@ const size_t N = 1024;
 const size_t M = 20;
 const size_t C = 5;
 const size_t B = 10;
+// the rows of a data handle are the leaves of a Merkle tree
+const size_t row_tree_depth = 10;
+static_assert((size_t(1) << row_tree_depth) == N, "the row tree has N leaves");
+// integer columns beyond M+1 are committed in groups of
+// column_group_width columns, see compute_data_handle
+const size_t column_group_width = 32;
+// the provenance circuit has keys for up to max_column_groups
+// groups, M + max_column_groups * column_group_width features
+const size_t max_column_groups = 9;
 
 typedef libff::edwards_pp snark_pp;
 typedef libff::Fr<snark_pp> FieldT;
 
+// multi-exponentiation engine of the prover, see --msm
+msm_engine prover_msm = msm_engine::libff;
+// encoding of the proofs in the YAML outputs, see --proof-format
+proof_format output_proof_format = proof_format::binary;
+// structure of the column hashes of new data handles, see --hash-mode
+hash_mode data_hash_mode = hash_mode::chain;
+// computation of the column hashes of new data handles, see --hash-engine
+hash_engine data_hash_engine = hash_engine::circuit;
+// cache of handles, model hashes and proofs, see --cache-dir
+std::shared_ptr<content_cache> result_cache;
+//! default size bound of --cache-dir, in MB
+const uint64_t default_cache_mb = 1024;
+
 template<typename FieldT>
 void print_protoboard_info(protoboard<FieldT>& pb)
 {
@@ -67,45 +104,155 @@ void print_matrix(const std::vector<std::vector<T>>& mat)
 //      - colName2
 
 /**
- * Utiliy Function to assign levels to categorical values
- * @ values : a vector of string values
- * @ return : each string value mapped to its lexicographic index
+ * Utiliy Function to assign levels to a dictionary encoded column
+ * Each distinct value is mapped to its lexicographic index (from 1)
+ * @param codes -- indices into dict, one per row
+ * @param dict -- distinct string values of the column, as the
+ * readers intern them
+ * @param levels -- set to the levels of the values in dict
+ * @return the level of every row
  */
-std::map<std::string, uint64_t>
-compute_levels(const std::vector<std::string>& values)
+std::vector<uint64_t>
+encode_levels(const std::vector<uint32_t>& codes,
+    const std::vector<std::string>& dict,
+    std::map<std::string, uint64_t>& levels)
 {
-    std::vector<std::string> vals(values);
-    std::sort(vals.begin(), vals.end());
-    auto it = std::unique(vals.begin(), vals.end());
-    vals.resize(std::distance(vals.begin(), it));
-    
-    std::map<std::string, uint64_t> levels;
-    for(size_t i=0; i < vals.size(); ++i)
-        levels[vals[i]] = i+1;
-    
-    return levels;
+    std::vector<uint32_t> order(dict.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&dict](uint32_t a, uint32_t b) {
+        return dict[a] < dict[b];
+    });
+
+    // insert in sorted order, so every insertion is at the end
+    std::vector<uint64_t> level_of_code(dict.size());
+    levels.clear();
+    for(uint32_t r=0; r < order.size(); ++r) {
+        levels.emplace_hint(levels.end(), dict[order[r]], r+1);
+        level_of_code[order[r]] = r+1;
+    }
+
+    std::vector<uint64_t> factor(codes.size());
+    for(size_t i=0; i < codes.size(); ++i)
+        factor[i] = level_of_code[codes[i]];
+
+    return factor;
 }
 
 /**
- * Applies the mapping to string values
- * @param values -- an array of string values
+ * Applies the mapping to a dictionary encoded column
+ * @param codes -- indices into dict, one per row
+ * @param dict -- distinct string values of the column
  * @param levels -- a map of levels
  * @return a numeric vector by applying levels to values
  */
 std::vector<uint64_t>
-apply_levels(const std::vector<std::string>& values,
+apply_levels(const std::vector<uint32_t>& codes,
+    const std::vector<std::string>& dict,
     const std::map<std::string, uint64_t>& levels)
 {
-    std::vector<uint64_t> factor;
-    for(size_t i=0; i < values.size(); ++i) {
-        assert(levels.find(values[i]) != levels.end());
-         factor.emplace_back(levels.find(values[i])->second);
+    // one lookup per distinct value
+    std::vector<uint64_t> code_levels(dict.size());
+    for(size_t i=0; i < dict.size(); ++i) {
+        auto it = levels.find(dict[i]);
+        assert(it != levels.end());
+        code_levels[i] = it->second;
+    }
+
+    std::vector<uint64_t> factor(codes.size());
+    for(size_t i=0; i < codes.size(); ++i)
+         factor[i] = code_levels[codes[i]];
+    
+    return factor;
+}
+
+/**
+ * Precomputed lookup from the values of a column to their levels,
+ * built once from a levels map and probed without allocating
+ */
+class levels_lookup {
+private:
+    string_dictionary values_;
+    std::vector<uint64_t> levels_;
+
+public:
+    levels_lookup(const std::map<std::string, uint64_t>& levels)
+    {
+        levels_.reserve(levels.size());
+        for(auto it=levels.begin(); it != levels.end(); ++it) {
+            values_.intern(it->first);
+            levels_.emplace_back(it->second);
+        }
+    };
+
+    // level of the value, 0 if the value has no level
+    uint64_t find(const char* value, size_t len) const
+    {
+        const uint32_t code = values_.find(value, len);
+        return (code == string_dictionary::npos) ? 0 : levels_[code];
+    };
+};
+
+/**
+ * Applies a precomputed lookup to a dictionary encoded column
+ * Values without a level are encoded as 0, which no level uses
+ * @param codes -- indices into dict, one per row
+ * @param dict -- distinct string values of the column
+ * @param unseen -- set to the values of dict without a level
+ * @return a numeric vector by applying levels to values
+ */
+std::vector<uint64_t>
+lookup_levels(const std::vector<uint32_t>& codes,
+    const std::vector<std::string>& dict,
+    const levels_lookup& lookup,
+    std::vector<std::string>& unseen)
+{
+    unseen.clear();
+    std::vector<uint64_t> code_levels(dict.size());
+    for(size_t i=0; i < dict.size(); ++i) {
+        code_levels[i] = lookup.find(dict[i].data(), dict[i].size());
+        if (code_levels[i] == 0)
+            unseen.emplace_back(dict[i]);
     }
+
+    std::vector<uint64_t> factor(codes.size());
+    for(size_t i=0; i < codes.size(); ++i)
+         factor[i] = code_levels[codes[i]];
     
     return factor;
 }
 
-typedef std::tuple<std::string, std::string> col_desc_t;
+/**
+ * Hex string of a field element, as used in the YAML outputs
+ */
+std::string field_to_hex(const FieldT& value)
+{
+    mpz_t v;
+    mpz_init(v);
+    value.as_bigint().to_mpz(v);
+    mpz_class hex(v);
+    mpz_clear(v);
+    return hex.get_str(16);
+}
+
+/**
+ * Parses a hex string into a field element
+ * @return false if hex is not a hex number below the modulus
+ */
+bool hex_to_field(const std::string& hex, FieldT& value)
+{
+    mpz_class v;
+    if (hex.empty() || v.set_str(hex, 16) != 0 || v < 0)
+        return false;
+    if (mpz_sizeinbase(v.get_mpz_t(), 2) > FieldT::num_bits)
+        return false;
+    libff::bigint<FieldT::num_limbs> b(v.get_mpz_t());
+    value = FieldT(b);
+    return value.as_bigint() == b;
+}
+
+typedef std::tuple<std::string, FieldT> col_desc_t;
+// column names of a group and the hash of their column hashes
+typedef std::tuple<std::vector<std::string>, FieldT> col_group_t;
 
 /**
  * Placeholder class to represent schema yaml
@@ -122,26 +269,50 @@ public:
  * @field: categorical_features -- tuples of categorical column name and hashes
  * @field: integer_features -- tuples of integer column name and hashes
  * @field: numeric_features -- tuples of numeric column name and hashes
+ * @field: categorical_groups, integer_groups -- columns beyond the
+ * first C categorical and M+1 integer ones, committed in groups of
+ * column_group_width columns by mimc_hash_fields of their hashes
  * @field: levels_map -- level map for categorical columns
+ * @field: version -- hash_mode of the column hashes
+ * @field: row_root -- root of the Merkle tree of the row hashes, for
+ * membership proofs of single rows (mimc_row_membership)
+ * @field: categorical_states, integer_states, row_state -- chain states
+ * of the column hashes and frontier of the row tree, kept by
+ * appendable handles only (see --append-rows)
  */ 
 class DataHandle {
 public:
+    typedef mimc_column_hasher<FieldT, N, packing_categorical> cat_state_t;
+    typedef mimc_column_hasher<FieldT, N, packing_integer> int_state_t;
+    typedef mimc_merkle_frontier<FieldT, row_tree_depth> row_state_t;
+
     std::vector<col_desc_t> categorical_features;
     std::vector<col_desc_t> integer_features;
     std::vector<col_desc_t> numeric_features;
+    std::vector<col_group_t> categorical_groups;
+    std::vector<col_group_t> integer_groups;
     // levels map
     std::map<std::string, std::map<std::string, uint64_t>> levels_map;
+    std::vector<cat_state_t> categorical_states;
+    std::vector<int_state_t> integer_states;
+    // handles without a version have chained hashes
+    uint64_t version = uint64_t(hash_mode::chain);
+    // older handles, and handles of more than N rows, have no row root
+    bool has_row_root = false;
+    FieldT row_root;
+    row_state_t row_state;
 public:
     // output data handle to a file
     int print(std::ostream& out) { 
         YAML::Emitter yout;
         yout << YAML::BeginMap ;
+        yout << YAML::Key << "Version" << YAML::Value << version;
         yout << YAML::Key << "CategoricalFeatures";
         yout << YAML::Value << YAML::BeginSeq;
         for(size_t i=0; i < categorical_features.size(); ++i)
             yout << YAML::Flow << YAML::BeginSeq <<
                 std::get<0>(categorical_features[i]) <<
-                std::get<1>(categorical_features[i]) << YAML::EndSeq;
+                field_to_hex(std::get<1>(categorical_features[i])) << YAML::EndSeq;
         yout << YAML::EndSeq;
 
         yout << YAML::Key << "IntegerFeatures";
@@ -149,16 +320,35 @@ public:
         for(size_t i=0; i < integer_features.size(); ++i)
             yout << YAML::Flow << YAML::BeginSeq <<
                 std::get<0>(integer_features[i]) <<
-                std::get<1>(integer_features[i]) << YAML::EndSeq;
+                field_to_hex(std::get<1>(integer_features[i])) << YAML::EndSeq;
         yout << YAML::EndSeq;
 
+        for(auto* groups : {&categorical_groups, &integer_groups}) {
+            if (groups->empty())
+                continue;
+            yout << YAML::Key << ((groups == &categorical_groups) ? "CategoricalGroups" : "IntegerGroups");
+            yout << YAML::Value << YAML::BeginSeq;
+            for(auto& group : *groups)
+                yout << YAML::Flow << YAML::BeginSeq << std::get<0>(group) <<
+                    field_to_hex(std::get<1>(group)) << YAML::EndSeq;
+            yout << YAML::EndSeq;
+        }
+
+        if (has_row_root)
+            yout << YAML::Key << "RowRoot" << YAML::Value << field_to_hex(row_root);
+
         // output levels map
         yout << YAML::Key << "LevelsMap";
         yout << YAML::Value << YAML::BeginMap;
-        for(auto tup : categorical_features) {
-            yout << YAML::Key << std::get<0>(tup);
+        std::vector<std::string> catColNames;
+        for(auto& tup : categorical_features)
+            catColNames.emplace_back(std::get<0>(tup));
+        for(auto& group : categorical_groups)
+            catColNames.insert(catColNames.end(), std::get<0>(group).begin(), std::get<0>(group).end());
+        for(auto& colName : catColNames) {
+            yout << YAML::Key << colName;
             yout << YAML::Value << YAML::BeginSeq;
-            auto levels = levels_map[std::get<0>(tup)];
+            auto levels = levels_map[colName];
             for(auto it=levels.begin(); it != levels.end(); ++it) {
                 yout << YAML::Flow << YAML::BeginSeq;
                 yout << it->first << it->second << YAML::EndSeq;
@@ -175,9 +365,12 @@ public:
 
 
 // class to represent a dataset (a csv file)        
+// categorical columns are dictionary encoded: row i of column j
+// holds the value categorical_dict[j][categorical_codes[j][i]]
 class Dataset {
 public:
-    std::vector<std::vector<std::string>> categorical_matrix;
+    std::vector<std::vector<std::string>> categorical_dict;
+    std::vector<std::vector<uint32_t>> categorical_codes;
     std::vector<std::vector<uint64_t>> integer_matrix;
     std::vector<std::vector<double>> numeric_matrix;
 
@@ -200,7 +393,13 @@ public:
     {
         std::cout << "NROWS: " << nrows << '\t' << "NCOLS: " << ncols << std::endl;
         std::cout << "Categorical Matrix: " << std::endl;
-        print_matrix<std::string>(categorical_matrix);
+        std::vector<std::vector<std::string>> categorical_head;
+        for(size_t j=0; j < categorical_codes.size(); ++j) {
+            categorical_head.emplace_back();
+            for(size_t i=0; i < std::min(nrows, size_t(5)); ++i)
+                categorical_head[j].emplace_back(categorical_dict[j][categorical_codes[j][i]]);
+        }
+        print_matrix<std::string>(categorical_head);
         std::cout << "Integer Matrix: " << std::endl;
         print_matrix<uint64_t>(integer_matrix);
         std::cout << "Numeric Matrix: " << std::endl;
@@ -249,8 +448,42 @@ read_schema_descriptor(const std::string& file)
     return sd;
 }
 
+//! largest integer value the circuits can represent
+const uint64_t max_integer_value = (uint64_t(1) << integer_bit_width) - 1;
+//! levels start at 1, this bounds the distinct values of a categorical column
+const size_t max_categorical_levels = (size_t(1) << categorical_bit_width) - 1;
+
+/**
+ * Checks that every column of the schema was found in a data file
+ * @input found names of the columns found in the file
+ * @return false (after reporting them) if some columns are missing
+ */
+bool check_schema_columns(
+    const SchemaDescriptor& sd,
+    const std::set<std::string>& found,
+    const std::string& file)
+{
+    bool ok = true;
+    for(auto* names : {&sd.categorical_features, &sd.integer_features, &sd.numeric_features})
+        for(auto& name : *names)
+            if (!found.count(name)) {
+                std::cout << "Column " << name << " of the schema not found in " << file << std::endl;
+                ok = false;
+            }
+    return ok;
+}
+
 /**
  * read a dataset, given the schema
+ * The file is memory mapped and parsed in a single pass: integer
+ * and numeric fields are converted straight into their columns,
+ * categorical fields are dictionary encoded as they are scanned.
+ * The header is checked against the schema before any row is read,
+ * columns outside the schema are skipped without being converted.
+ * Values are validated as they are scanned: integers must fit in
+ * integer_bit_width bits and a categorical column may not have more
+ * distinct values than categorical_bit_width bits can number; the
+ * first offending field is reported with its row and column.
  * @input file path to data file
  * @input sd the pointer to schema object
  * @return pointer to Dataset object, nullptr in case of failure
@@ -268,47 +501,452 @@ read_dataset(
         sd->integer_features.end());
     std::set<std::string> numSet(sd->numeric_features.begin(),
         sd->numeric_features.end());
-    
-    rapidcsv::Document doc(file);
-    size_t nrows = doc.GetRowCount();
-    size_t ncols = doc.GetColumnCount();
-    ds->nrows = nrows;
-    ds->ncols = ncols;
 
-    for(size_t i=0; i < ncols; ++i) {
-        auto colName = doc.GetColumnName(i);
+    auto t0 = libff::get_nsec_time();
+    mapped_file mfile;
+    if (!mfile.open(file)) {
+        std::cout << "Unable to open " << file << std::endl;
+        return nullptr;
+    }
+
+    csv_scanner scanner(mfile.data(), mfile.data() + mfile.size());
+    const char* field;
+    size_t len;
+
+    // the header decides, for every position in a row, the
+    // kind of the column and its index among that kind
+    enum column_kind { categorical, integer, numeric, skipped };
+    std::vector<std::pair<column_kind, size_t>> slots;
+    std::vector<std::string> colNames;
+    std::set<std::string> found;
+    if (!scanner.next_row()) {
+        std::cout << "Empty data file " << file << std::endl;
+        return nullptr;
+    }
+    while (scanner.next_field(field, len)) {
+        std::string colName(field, len);
+        colNames.emplace_back(colName);
+        if (!found.insert(colName).second) {
+            std::cout << "Column " << colName << " appears twice in " << file << std::endl;
+            return nullptr;
+        }
         if (catSet.count(colName)) {
-            auto col = doc.GetColumn<std::string>(i);
-            ds->categorical_matrix.emplace_back(col);
+            slots.emplace_back(categorical, ds->n_cat_features++);
             ds->catColNames.emplace_back(colName);
-            ds->n_cat_features++;
         } else if (intSet.count(colName)) {
-            ds->integer_matrix.emplace_back(doc.GetColumn<uint64_t>(colName));
+            slots.emplace_back(integer, ds->n_integer_features++);
             ds->intColNames.emplace_back(colName);
-            ds->n_integer_features++;
         } else if (numSet.count(colName)) {
-            ds->numeric_matrix.emplace_back(doc.GetColumn<double>(colName));
+            slots.emplace_back(numeric, ds->n_numeric_features++);
             ds->numColNames.emplace_back(colName);
-            ds->n_numeric_features++;
         } else {
-            std::cout << "Column " << colName << " not found in descriptor" << std::endl;
+            slots.emplace_back(skipped, 0);
+        }
+    }
+    if (!check_schema_columns(*sd, found, file))
+        return nullptr;
+
+    const size_t ncols = slots.size();
+    ds->ncols = ds->n_cat_features + ds->n_integer_features + ds->n_numeric_features;
+    if (ds->ncols < ncols)
+        std::cout << "Skipping " << ncols - ds->ncols << " columns outside the schema" << std::endl;
+    ds->categorical_dict.resize(ds->n_cat_features);
+    ds->categorical_codes.resize(ds->n_cat_features);
+    ds->integer_matrix.resize(ds->n_integer_features);
+    ds->numeric_matrix.resize(ds->n_numeric_features);
+    std::vector<string_dictionary> dicts(ds->n_cat_features);
+
+    size_t nrows = 0;
+    while (scanner.next_row()) {
+        size_t j = 0;
+        while (scanner.next_field(field, len)) {
+            if (j >= ncols) {
+                std::cout << "Row " << scanner.row() << ": more than " << ncols << " fields" << std::endl;
+                return nullptr;
+            }
+
+            const size_t k = slots[j].second;
+            switch (slots[j].first) {
+                case categorical:
+                    ds->categorical_codes[k].emplace_back(dicts[k].intern(field, len));
+                    if (dicts[k].size() > max_categorical_levels) {
+                        std::cout << "Row " << scanner.row() << ", column " << j+1 << " (" << colNames[j] 
+                            << "): more than " << max_categorical_levels << " distinct values" << std::endl;
+                        return nullptr;
+                    }
+                    break;
+                case integer: {
+                    uint64_t value;
+                    if (!parse_uint64(field, len, value)) {
+                        std::cout << "Row " << scanner.row() << ", column " << j+1 << " (" << colNames[j] 
+                            << "): invalid integer '" << std::string(field, len) << "'" << std::endl;
+                        return nullptr;
+                    }
+                    if (value > max_integer_value) {
+                        std::cout << "Row " << scanner.row() << ", column " << j+1 << " (" << colNames[j] 
+                            << "): integer " << value << " exceeds " << integer_bit_width << " bits" << std::endl;
+                        return nullptr;
+                    }
+                    ds->integer_matrix[k].emplace_back(value);
+                    break;
+                }
+                case numeric: {
+                    double value;
+                    if (!parse_double(field, len, value)) {
+                        std::cout << "Row " << scanner.row() << ", column " << j+1 << " (" << colNames[j] 
+                            << "): invalid number '" << std::string(field, len) << "'" << std::endl;
+                        return nullptr;
+                    }
+                    ds->numeric_matrix[k].emplace_back(value);
+                    break;
+                }
+                case skipped:
+                    break;
+            }
+            ++j;
+        }
+
+        if (j != ncols) {
+            std::cout << "Row " << scanner.row() << ": expected " << ncols 
+                << " fields, found " << j << std::endl;
             return nullptr;
         }
+        ++nrows;
     }
+    ds->nrows = nrows;
+    for(size_t k=0; k < dicts.size(); ++k)
+        for(uint32_t code=0; code < dicts[k].size(); ++code)
+            ds->categorical_dict[k].emplace_back(dicts[k].str(code));
+
+    auto t1 = libff::get_nsec_time();
+    const double secs = double(t1 - t0) / 1e9;
+    std::cout << "Parsed [ " << file << " ] Rows: [ " << nrows << " ] Bytes: [ " << mfile.size() 
+        << " ] Time: [ " << secs << " s ] Throughput: [ " 
+        << ((secs > 0) ? (mfile.size() / 1e6) / secs : 0) << " MB/s ]" << std::endl;
 
     return ds;
 }
 
+//! magic string at the start of a binary data handle
+const char data_handle_magic[8] = {'T', 'A', 'I', 'D', 'H', 'B', '0', '4'};
+
+// Binary data handle layout (see binary_writer):
+//  magic, version
+//  index: categorical count, integer count, then per column
+//      name and hash, as the limbs of the field element, then
+//      categorical group count, integer group count, and per
+//      group the column count, names and hash, then
+//      whether there is a row root and the row root
+//  levels map: column count, then per column name, values
+//      (concatenated in sorted order), value offsets, levels
+//  chain states, appendable handles only: row count, then per
+//      categorical and integer column the chain key, the values
+//      of the partial chunk and the hashes of the complete leaves,
+//      then the frontier of the row tree
+// The index comes first, so that readers which only need the
+// column hashes stop before the levels.
+
+// field elements are stored as the limbs of their bigint
+void write_field(binary_writer& writer, const FieldT& value)
+{
+    auto b = value.as_bigint();
+    writer.write_array(b.data, FieldT::num_limbs);
+}
+
+// @return false if the limbs are not those of a field element
+bool read_field(binary_reader& reader, FieldT& value)
+{
+    size_t nlimbs;
+    const mp_limb_t* limbs = reader.view_array<mp_limb_t>(nlimbs);
+    if (!reader.ok() || nlimbs != FieldT::num_limbs)
+        return false;
+    libff::bigint<FieldT::num_limbs> b;
+    std::memcpy(b.data, limbs, sizeof(b.data));
+    // the value must be reduced, or it would not read back as is
+    value = FieldT(b);
+    return value.as_bigint() == b;
+}
+
+template<typename StateT>
+void write_chain_state(binary_writer& writer, const StateT& state)
+{
+    write_field(writer, state.key_);
+    writer.write_array(state.tail_);
+    writer.write_u64(state.leaves_.size());
+    for(auto& leaf : state.leaves_)
+        write_field(writer, leaf);
+}
+
+/**
+ * Writes the data handle in the binary layout, without magic,
+ * also used for the data handle of a dataset cache
+ */
+void write_data_handle_body(binary_writer& writer, const DataHandle& dhandle)
+{
+    writer.write_u64(dhandle.version);
+    writer.write_u64(dhandle.categorical_features.size());
+    writer.write_u64(dhandle.integer_features.size());
+    for(auto* features : {&dhandle.categorical_features, &dhandle.integer_features}) {
+        for(auto& tup : *features) {
+            writer.write_string(std::get<0>(tup));
+            write_field(writer, std::get<1>(tup));
+        }
+    }
+    writer.write_u64(dhandle.categorical_groups.size());
+    writer.write_u64(dhandle.integer_groups.size());
+    for(auto* groups : {&dhandle.categorical_groups, &dhandle.integer_groups}) {
+        for(auto& group : *groups) {
+            writer.write_u64(std::get<0>(group).size());
+            for(auto& colName : std::get<0>(group))
+                writer.write_string(colName);
+            write_field(writer, std::get<1>(group));
+        }
+    }
+    writer.write_u64(dhandle.has_row_root);
+    if (dhandle.has_row_root)
+        write_field(writer, dhandle.row_root);
+
+    writer.write_u64(dhandle.levels_map.size());
+    for(auto& col : dhandle.levels_map) {
+        std::string values;
+        std::vector<uint64_t> offsets(1, 0), levels;
+        for(auto& level : col.second) {
+            values += level.first;
+            offsets.emplace_back(values.size());
+            levels.emplace_back(level.second);
+        }
+        writer.write_string(col.first);
+        writer.write_array(values.data(), values.size());
+        writer.write_array(offsets);
+        writer.write_array(levels);
+    }
+
+    if (dhandle.categorical_states.empty())
+        return;
+    writer.write_u64(dhandle.categorical_states[0].size_);
+    for(auto& state : dhandle.categorical_states)
+        write_chain_state(writer, state);
+    for(auto& state : dhandle.integer_states)
+        write_chain_state(writer, state);
+    if (dhandle.has_row_root)
+        for(auto& node : dhandle.row_state.frontier_)
+            write_field(writer, node);
+}
+
+/**
+ * Reads the chain state of a column, with nrows values
+ */
+template<typename StateT>
+bool read_chain_state(binary_reader& reader, hash_mode mode, size_t nrows, StateT& state)
+{
+    FieldT key;
+    if (!read_field(reader, key))
+        return false;
+    std::vector<uint64_t> tail;
+    reader.read_array(tail);
+    // the count is checked before it sizes anything
+    const uint64_t n_leaves = reader.read_u64();
+    if (!reader.ok() || n_leaves > StateT::chunks)
+        return false;
+    std::vector<FieldT> leaves(n_leaves);
+    for(auto& leaf : leaves)
+        if (!read_field(reader, leaf))
+            return false;
+    state = StateT(mode, key, tail, leaves, nrows);
+    return state.consistent();
+}
+
+/**
+ * Reads a data handle written by write_data_handle_body
+ * @input with_levels false to read the column hashes only
+ * @return false if the data is malformed
+ */
+bool read_data_handle_body(
+    binary_reader& reader,
+    DataHandle& dhandle,
+    bool with_levels)
+{
+    hash_mode mode;
+    dhandle.version = reader.read_u64();
+    if (!hash_mode_of_version(dhandle.version, mode))
+        return false;
+    const size_t n_cat = reader.read_u64();
+    const size_t n_int = reader.read_u64();
+    for(size_t i=0; reader.ok() && i < n_cat + n_int; ++i) {
+        auto colName = reader.read_string();
+        FieldT hash;
+        if (!read_field(reader, hash))
+            return false;
+        auto& features = (i < n_cat) ? dhandle.categorical_features : dhandle.integer_features;
+        features.emplace_back(col_desc_t(colName, hash));
+    }
+    const size_t n_cat_groups = reader.read_u64();
+    const size_t n_int_groups = reader.read_u64();
+    for(size_t i=0; reader.ok() && i < n_cat_groups + n_int_groups; ++i) {
+        const size_t ncols = reader.read_u64();
+        if (!reader.ok() || ncols > column_group_width)
+            return false;
+        std::vector<std::string> colNames;
+        for(size_t k=0; k < ncols; ++k)
+            colNames.emplace_back(reader.read_string());
+        FieldT hash;
+        if (!read_field(reader, hash))
+            return false;
+        auto& groups = (i < n_cat_groups) ? dhandle.categorical_groups : dhandle.integer_groups;
+        groups.emplace_back(col_group_t(colNames, hash));
+    }
+    dhandle.has_row_root = reader.read_u64();
+    if (dhandle.has_row_root && !read_field(reader, dhandle.row_root))
+        return false;
+    if (!with_levels)
+        return reader.ok();
+
+    const size_t ncols = reader.read_u64();
+    for(size_t i=0; reader.ok() && i < ncols; ++i) {
+        auto colName = reader.read_string();
+        size_t nchars, noffsets, nlevels;
+        const char* values = reader.view_array<char>(nchars);
+        const uint64_t* offsets = reader.view_array<uint64_t>(noffsets);
+        const uint64_t* levels = reader.view_array<uint64_t>(nlevels);
+        if (!reader.ok() || noffsets != nlevels + 1)
+            return false;
+        // values are sorted, so every insertion is at the end
+        auto& col = dhandle.levels_map[colName];
+        for(size_t k=0; k < nlevels; ++k) {
+            if (offsets[k] > offsets[k+1] || offsets[k+1] > nchars)
+                return false;
+            col.emplace_hint(col.end(),
+                std::string(values + offsets[k], offsets[k+1] - offsets[k]), levels[k]);
+        }
+    }
+    if (!reader.ok() || reader.at_end())
+        return reader.ok();
+
+    const size_t nrows = reader.read_u64();
+    dhandle.categorical_states.resize(n_cat);
+    dhandle.integer_states.resize(n_int);
+    for(auto& state : dhandle.categorical_states)
+        if (!read_chain_state(reader, mode, nrows, state))
+            return false;
+    for(auto& state : dhandle.integer_states)
+        if (!read_chain_state(reader, mode, nrows, state))
+            return false;
+    if (dhandle.has_row_root) {
+        std::vector<FieldT> frontier(row_tree_depth + 1);
+        for(auto& node : frontier)
+            if (!read_field(reader, node))
+                return false;
+        dhandle.row_state = DataHandle::row_state_t(frontier, nrows);
+        return dhandle.row_state.consistent();
+    }
+    return reader.ok();
+}
+
+/**
+ * Writes the data handle in the binary layout
+ * @return false in case of failure
+ */
+bool write_data_handle(const std::string& file, const DataHandle& dhandle)
+{
+    std::ofstream out(file, std::ios::binary);
+    if (!out) return false;
+    binary_writer writer(out);
+    writer.write_magic(data_handle_magic);
+    write_data_handle_body(writer, dhandle);
+    out.close();
+    return !out.fail();
+}
+
+/**
+ * Checks whether file has a .yaml or .yml extension
+ */
+bool is_yaml_file(const std::string& file)
+{
+    auto ends_with = [&file](const std::string& ext) {
+        return file.size() >= ext.size() &&
+            file.compare(file.size() - ext.size(), ext.size(), ext) == 0;
+    };
+    return ends_with(".yaml") || ends_with(".yml");
+}
+
+/**
+ * Writes the data handle as YAML if file ends in .yaml or .yml,
+ * in the binary layout otherwise
+ * @return false in case of failure
+ */
+bool save_data_handle(const std::string& file, DataHandle& dhandle)
+{
+    if (!is_yaml_file(file))
+        return write_data_handle(file, dhandle);
+
+    if (!dhandle.categorical_states.empty())
+        std::cout << "Chain states and the row tree frontier are not kept in YAML data handles" << std::endl;
+    std::ofstream out(file);
+    dhandle.print(out);
+    out.close();
+    return !out.fail();
+}
+
+/**
+ * Checks whether file starts with the binary data handle magic
+ */
+bool is_binary_data_handle(const std::string& file)
+{
+    std::ifstream in(file, std::ios::binary);
+    char magic[sizeof(data_handle_magic)] = {0};
+    in.read(magic, sizeof(magic));
+    return in.good() && (std::memcmp(magic, data_handle_magic, sizeof(magic)) == 0);
+}
+
+/**
+ * Reads a binary data handle written by write_data_handle.
+ * The file is memory mapped, hashes are copied out as raw limbs.
+ * @input with_levels false to read the column hashes only
+ * @return pointer to DataHandle object, nullptr to indicate failure
+ */
+std::shared_ptr<DataHandle>
+read_binary_data_handle(const std::string& data_handle_file, bool with_levels)
+{
+    mapped_file mfile;
+    if (!mfile.open(data_handle_file)) {
+        std::cout << "Unable to open " << data_handle_file << std::endl;
+        return nullptr;
+    }
+    binary_reader reader(mfile.data(), mfile.data() + mfile.size());
+    std::shared_ptr<DataHandle> dhandle(new DataHandle());
+    if (!reader.check_magic(data_handle_magic) ||
+        !read_data_handle_body(reader, *dhandle, with_levels) ||
+        (with_levels && !reader.at_end())) {
+        std::cout << "Malformed datahandle " << data_handle_file << std::endl;
+        return nullptr;
+    }
+    return dhandle;
+}
+
 /**
- * Read the datahandle descriptor
+ * Read the datahandle descriptor, either binary (as written by
+ * --gen-handle) or YAML (as exported for humans)
  * @input data_handle_file path to file containing datahandle
+ * @input with_levels false if only the column hashes are needed
  * @return pointer to DataHandle object, nullptr to indicate failure
  */
 std::shared_ptr<DataHandle>
-read_data_handle(const std::string& data_handle_file)
+read_data_handle(const std::string& data_handle_file, bool with_levels = true)
 {
+    // hashes are read into field elements
+    snark_pp::init_public_params();
+    if (is_binary_data_handle(data_handle_file))
+        return read_binary_data_handle(data_handle_file, with_levels);
+
     std::shared_ptr<DataHandle> dhandle(new DataHandle());
     YAML::Node top = YAML::LoadFile(data_handle_file);
+    hash_mode mode;
+    if (top["Version"])
+        dhandle->version = top["Version"].as<uint64_t>();
+    if (!hash_mode_of_version(dhandle->version, mode)) {
+        std::cout << "Unknown datahandle version " << dhandle->version << std::endl;
+        return nullptr;
+    }
     std::vector<col_desc_t> categorical_features, integer_features;
     std::map<std::string, std::map<std::string, uint64_t>> levels_map;
     // read categorical features
@@ -317,7 +955,11 @@ read_data_handle(const std::string& data_handle_file)
         if (cat_features_node.IsSequence()) {
             for(size_t i=0; i < cat_features_node.size(); ++i) {
                 auto colName = cat_features_node[i][0].as<std::string>();
-                auto colHash = cat_features_node[i][1].as<std::string>();
+                FieldT colHash;
+                if (!hex_to_field(cat_features_node[i][1].as<std::string>(), colHash)) {
+                    std::cout << "Malformed hash of column " << colName << std::endl;
+                    return nullptr;
+                }
                 categorical_features.emplace_back(col_desc_t(colName, colHash));
             }
         } else {
@@ -331,7 +973,11 @@ read_data_handle(const std::string& data_handle_file)
         if (int_features_node.IsSequence()) {
             for(size_t i=0; i < int_features_node.size(); ++i) {
                 auto colName = int_features_node[i][0].as<std::string>();
-                auto colHash = int_features_node[i][1].as<std::string>();
+                FieldT colHash;
+                if (!hex_to_field(int_features_node[i][1].as<std::string>(), colHash)) {
+                    std::cout << "Malformed hash of column " << colName << std::endl;
+                    return nullptr;
+                }
                 integer_features.emplace_back(col_desc_t(colName, colHash));
             }
         } else {
@@ -340,6 +986,33 @@ read_data_handle(const std::string& data_handle_file)
         }
     } 
 
+    for(auto* groups : {&dhandle->categorical_groups, &dhandle->integer_groups}) {
+        YAML::Node groups_node = top[(groups == &dhandle->categorical_groups) ? "CategoricalGroups" : "IntegerGroups"];
+        if (!groups_node)
+            continue;
+        if (!groups_node.IsSequence()) {
+            std::cout << "Malformed datahandle" << std::endl;
+            return nullptr;
+        }
+        for(size_t i=0; i < groups_node.size(); ++i) {
+            auto colNames = groups_node[i][0].as<std::vector<std::string>>();
+            FieldT groupHash;
+            if (!hex_to_field(groups_node[i][1].as<std::string>(), groupHash)) {
+                std::cout << "Malformed hash of column group " << i << std::endl;
+                return nullptr;
+            }
+            groups->emplace_back(col_group_t(colNames, groupHash));
+        }
+    }
+
+    if (top["RowRoot"]) {
+        if (!hex_to_field(top["RowRoot"].as<std::string>(), dhandle->row_root)) {
+            std::cout << "Malformed row root" << std::endl;
+            return nullptr;
+        }
+        dhandle->has_row_root = true;
+    }
+
     if (top["LevelsMap"]) {
         YAML::Node levelsMap = top["LevelsMap"];
         if (levelsMap.IsMap()) {
@@ -371,193 +1044,1509 @@ read_data_handle(const std::string& data_handle_file)
     return dhandle;
 }
     
+/**
+ * Leaves of the row tree of a data handle, the hashes of the rows
+ * of its columns (categorical levels, then integers). Rows are
+ * hashed in parallel.
+ * @input columns the columns of the data handle, 0 past their end
+ */
+std::vector<FieldT> compute_row_leaves(
+    const std::vector<column_span<uint64_t>>& columns,
+    size_t nrows)
+{
+    std::vector<FieldT> leaves(nrows);
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for(size_t r=0; r < nrows; ++r) {
+        std::vector<uint64_t> row(columns.size());
+        for(size_t c=0; c < columns.size(); ++c)
+            row[c] = columns[c].get(r);
+        leaves[r] = mimc_row_leaf<FieldT>(row.data(), row.size());
+    }
+    return leaves;
+}
+
+/**
+ * Number of column groups of a dataset with n_int integer columns,
+ * the last of which is the target: the features beyond the first
+ * M take groups of column_group_width columns. A model of n_int
+ * coefficients, the offset last, has as many.
+ */
+size_t integer_column_groups(size_t n_int)
+{
+    const size_t features = (n_int > 0) ? n_int - 1 : 0;
+    return (features > M) ? libff::div_ceil(features - M, column_group_width) : 0;
+}
+
+/**
+ * Slot of integer column k of n_int in a data handle with the given
+ * number of features. Features keep their order, the last column
+ * (the target) follows the 0-padded features, where the provenance
+ * circuit reads it.
+ */
+size_t integer_slot(size_t k, size_t n_int, size_t features)
+{
+    return (k + 1 == n_int) ? features : k;
+}
+
+/**
+ * Calls f.template run<G>() for the number of column groups given
+ * at run time, which instantiates the circuits of every number of
+ * groups up to G
+ */
+template<size_t G>
+struct column_groups_dispatch {
+    template<typename F>
+    static void run(size_t groups, F& f)
+    {
+        if (groups == G)
+            f.template run<G>();
+        else
+            column_groups_dispatch<G-1>::run(groups, f);
+    }
+};
+
+template<>
+struct column_groups_dispatch<0> {
+    template<typename F>
+    static void run(size_t, F& f) { f.template run<0>(); }
+};
+
 /**
  * Computes datahandle descriptor for tabular data
- * A maximum of C categorical columns are considered part
- * of datahandle. If the dataset has fewer than C categorical
- * columns, the "dummy" categorical columns consisting of all 
- * 0s are appended to make C categorical columns. The hash is
- * then computed for each column. The order of existing columns
- * is preserved. For > C, columns, the first C columns are included.
- * For integer, columns, upto a maximum M+1 colums are considered
+ * The first C categorical columns are committed one by one. If the
+ * dataset has fewer than C categorical columns, the "dummy"
+ * categorical columns consisting of all 0s are appended to make C
+ * categorical columns. The order of existing columns is preserved.
+ * Integer columns are the features, padded with "dummy" features,
+ * then the target (the last integer column): M+1 columns committed
+ * one by one, and for datasets of more than M features g more
+ * groups of column_group_width columns. Categorical columns beyond
+ * C are committed in groups as well, so no column is left out.
+ * The rows are also committed to by the root of a Merkle tree of
+ * their hashes, for datasets of at most N rows without groups.
  * @input dataset the dataset representing csv data
- * @return pointer to DataHandle object as described above.
+ * @input appendable whether to keep the chain states of the
+ * column hashes, for --append-rows
+ * @input mode structure of the column hashes
+ * @input engine computation of the column hashes, the lanes engine
+ * falls back to the circuit for more than N rows. The columns of
+ * groups are hashed with the lanes.
+ * @return pointer to DataHandle object as described above, nullptr
+ * if the dataset has more columns than the groups can hold
  */
 std::shared_ptr<DataHandle>
-compute_data_handle(const std::shared_ptr<Dataset> dataset)
+compute_data_handle(
+    const std::shared_ptr<Dataset> dataset,
+    bool appendable = false,
+    hash_mode mode = hash_mode::chain,
+    hash_engine engine = hash_engine::circuit)
 {
     // currently we don't use numeric features for data-handle
     // this is beacuse, numeric features are expensive to support
 
-    std::vector<std::vector<std::string>> cat_features =
-        dataset->categorical_matrix;
-    cat_features.resize(C, std::vector<std::string>(dataset->nrows, "NA"));
+    const size_t n_int = dataset->integer_matrix.size();
+    const size_t groups = integer_column_groups(n_int);
+    const size_t features = M + groups * column_group_width;
+    const bool wide = (groups > 0 || dataset->categorical_codes.size() > C);
+    if (groups > max_column_groups) {
+        std::cout << "Data handles have at most " << M + max_column_groups * column_group_width
+            << " integer features, the dataset has " << n_int - 1 << std::endl;
+        return nullptr;
+    }
+    if (wide && dataset->nrows > N) {
+        std::cout << "Column groups cover at most " << N << " rows" << std::endl;
+        return nullptr;
+    }
+
+    // missing columns are a dictionary with a single "NA" entry
+    const size_t n_cat = std::min(dataset->categorical_codes.size(), C);
+    const size_t n_cat_all = std::max(dataset->categorical_codes.size(), C);
+    const std::vector<std::string> dummy_dict(1, "NA");
+    const std::vector<uint32_t> dummy_codes(dataset->nrows, 0);
     auto catColNames = dataset->catColNames;
-    catColNames.resize(C, "Dummy");
+    catColNames.resize(n_cat_all, "Dummy");
      
-    std::vector<std::vector<uint64_t>> integer_features =
-        dataset->integer_matrix;
-    integer_features.resize(M+1, std::vector<uint64_t>(dataset->nrows, 0));
-    auto intColNames = dataset->intColNames;
-    intColNames.resize(M+1, "Dummy");
+    // integer columns are read in place, missing ones are 0
+    std::vector<column_span<uint64_t>> integer_features(features + 1);
+    std::vector<std::string> intColNames(features + 1, "Dummy");
+    for(size_t k=0; k < n_int; ++k) {
+        integer_features[integer_slot(k, n_int, features)] = dataset->integer_matrix[k];
+        intColNames[integer_slot(k, n_int, features)] = dataset->intColNames[k];
+    }
 
     snark_pp::init_public_params();
-    protoboard<FieldT> pb;
 
-    data_source<FieldT, N, C, M+1> ds(pb, dataset->nrows, "data-source");
-    ds.allocate();
     // convert categorical features to levels
-    // and compute the levels map
-    std::vector<std::vector<uint64_t>> cat_features_levels;
+    // and compute the levels map, one column per thread
+    std::vector<std::vector<uint64_t>> cat_features_levels(n_cat_all);
+    std::vector<std::map<std::string, uint64_t>> cat_levels(n_cat_all);
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for(size_t i=0; i < n_cat_all; ++i)
+        cat_features_levels[i] = (i < n_cat || i >= C) ?
+            encode_levels(dataset->categorical_codes[i], dataset->categorical_dict[i], cat_levels[i]) :
+            encode_levels(dummy_codes, dummy_dict, cat_levels[i]);
+
     std::map<std::string, std::map<std::string, uint64_t>> levels_map;
-    for(size_t i=0; i < cat_features.size(); ++i) {
-        auto colName = catColNames[i];
-        levels_map[colName] = compute_levels(cat_features[i]);
-        cat_features_levels.emplace_back(
-            apply_levels(cat_features[i], levels_map[colName]));
+    for(size_t i=0; i < n_cat_all; ++i)
+        levels_map[catColNames[i]] = std::move(cat_levels[i]);
+
+    // the columns committed one by one
+    auto cat_columns = column_spans(cat_features_levels);
+    const std::vector<column_span<uint64_t>> cat_features(cat_columns.begin(), cat_columns.begin() + C);
+    const std::vector<column_span<uint64_t>> int_features(integer_features.begin(), integer_features.begin() + M+1);
+
+    std::vector<FieldT> cHashes, iHashes;
+    if (engine == hash_engine::lanes && dataset->nrows <= N) {
+        cHashes = mimc_hash_columns<FieldT, N, packing_categorical>(
+            cat_features, dataset->nrows, mode);
+        iHashes = mimc_hash_columns<FieldT, N, packing_integer>(
+            int_features, dataset->nrows, mode);
+    } else {
+        protoboard<FieldT> pb;
+        data_source<FieldT, N, C, M+1> ds(pb, dataset->nrows, "data-source", mode);
+        ds.allocate();
+        ds.set_values(cat_features, int_features);
+        ds.generate_r1cs_witness();
+        cHashes = ds.cHashes_;
+        iHashes = ds.iHashes_;
     }
 
-    ds.set_values(cat_features_levels, integer_features);
-    ds.generate_r1cs_witness();
-
     std::shared_ptr<DataHandle> dhandle(new DataHandle());
-    for(size_t i=0; i < C; ++i) {
-        auto colName = catColNames[i];
-        mpz_t col_hash;
-        mpz_init(col_hash);
-        ds.cHashes_[i].as_bigint().to_mpz(col_hash);
-        mpz_class colHash(col_hash);
-        dhandle->categorical_features.emplace_back(
-            col_desc_t(colName, colHash.get_str(16)));
-        mpz_clear(col_hash);
-    }
+    dhandle->version = uint64_t(mode);
+    for(size_t i=0; i < C; ++i)
+        dhandle->categorical_features.emplace_back(col_desc_t(catColNames[i], cHashes[i]));
         
-    for(size_t i=0; i < M+1; ++i) {
-        auto colName = intColNames[i];
-        mpz_t col_hash;
-        mpz_init(col_hash);
-        ds.iHashes_[i].as_bigint().to_mpz(col_hash);
-        mpz_class colHash(col_hash);
-        dhandle->integer_features.emplace_back(
-            col_desc_t(colName, colHash.get_str(16)));
-        mpz_clear(col_hash);
-    }
+    for(size_t i=0; i < M+1; ++i)
+        dhandle->integer_features.emplace_back(col_desc_t(intColNames[i], iHashes[i]));
     dhandle->levels_map = levels_map;
 
+    if (wide) {
+        // the columns after the first first_col of colNames, in
+        // groups of column_group_width (the last may be shorter)
+        auto add_groups = [](
+            const std::vector<std::string>& colNames,
+            size_t first_col,
+            const std::vector<FieldT>& hashes,
+            std::vector<col_group_t>& groups)
+        {
+            for(size_t begin=0; begin < hashes.size(); begin += column_group_width) {
+                const size_t end = std::min(begin + column_group_width, hashes.size());
+                groups.emplace_back(col_group_t(
+                    std::vector<std::string>(colNames.begin() + first_col + begin, colNames.begin() + first_col + end),
+                    mimc_hash_fields(hashes.data() + begin, end - begin)));
+            }
+        };
+        add_groups(catColNames, C, mimc_hash_columns<FieldT, N, packing_categorical>(
+            std::vector<column_span<uint64_t>>(cat_columns.begin() + C, cat_columns.end()),
+            dataset->nrows, mode), dhandle->categorical_groups);
+        add_groups(intColNames, M+1, mimc_hash_columns<FieldT, N, packing_integer>(
+            std::vector<column_span<uint64_t>>(integer_features.begin() + M+1, integer_features.end()),
+            dataset->nrows, mode), dhandle->integer_groups);
+    }
+
+    // rows of wide datasets are wider than the row tree circuit
+    std::vector<FieldT> row_leaves;
+    if (dataset->nrows <= N && !wide) {
+        auto columns = column_spans(cat_features_levels);
+        columns.insert(columns.end(), integer_features.begin(), integer_features.end());
+        row_leaves = compute_row_leaves(columns, dataset->nrows);
+        dhandle->has_row_root = true;
+        dhandle->row_root = mimc_merkle_tree<FieldT, row_tree_depth>(row_leaves).root();
+    }
+
+    if (appendable && wide) {
+        std::cout << "Data handles with column groups are not appendable" << std::endl;
+    } else if (appendable && dataset->nrows > N) {
+        std::cout << "Chain states are kept for at most " << N << " rows, the data handle is not appendable" << std::endl;
+    } else if (appendable) {
+        // hash the columns again natively, keeping the states,
+        // and check them against the hashes above
+        const std::vector<uint64_t> zeros(dataset->nrows, 0);
+        dhandle->categorical_states.assign(C, DataHandle::cat_state_t(mode));
+        dhandle->integer_states.assign(M+1, DataHandle::int_state_t(mode));
+        bool consistent = true;
+#ifdef MULTICORE
+#pragma omp parallel for reduction(&&:consistent)
+#endif
+        for(size_t i=0; i < C + M+1; ++i) {
+            if (i < C) {
+                auto& state = dhandle->categorical_states[i];
+                state.append(cat_features_levels[i].data(), cat_features_levels[i].size());
+                consistent = consistent && (state.hash() == cHashes[i]);
+            } else {
+                auto& state = dhandle->integer_states[i-C];
+                auto& column = integer_features[i-C];
+                state.append(column.data(), column.size());
+                state.append(zeros.data(), dataset->nrows - column.size());
+                consistent = consistent && (state.hash() == iHashes[i-C]);
+            }
+        }
+        if (!consistent) {
+            std::cout << "Chain states do not match the column hashes, the data handle is not appendable" << std::endl;
+            dhandle->categorical_states.clear();
+            dhandle->integer_states.clear();
+        }
+        for(auto& leaf : row_leaves)
+            dhandle->row_state.append(leaf);
+    }
+
     return dhandle;
 }
 
 /**
- * Computes hash of a linear model
- * A model is expressed as M+1 coefficients (for configured value M)
- * i.e W_0, W_1,..., W_M. We use W_M as the offset term, instead of W_0
- * Thus, the prediction for x_0,...x_{M-1} is W_0.x_0 + ... W_M
+ * Extends the column hashes of an appendable data handle with
+ * the rows of a dataset, hashing only the new rows. The result
+ * is the data handle of the concatenated data. Categorical values
+ * must already have a level, since a new level would renumber
+ * the existing ones.
+ * @input data_handle_file the file dhandle was read from
+ * @return pointer to the extended DataHandle, nullptr in case of failure
  */
-std::string 
-compute_model_hash(const std::vector<double>& coefficients)
+std::shared_ptr<DataHandle>
+append_data_handle(
+    const std::shared_ptr<DataHandle> dhandle,
+    const std::shared_ptr<Dataset> dataset,
+    const std::string& data_handle_file)
 {
-    snark_pp::init_public_params();
-    protoboard<FieldT> pb;
-   
-    std::shared_ptr<signed_vector<FieldT, M+1>> model;
-    pb_variable<FieldT> wsize;
-    pb_variable_array<FieldT> w_selector;
-    std::shared_ptr<size_selector_gadget<FieldT, M+1>> w_size_selector;
-    std::shared_ptr<mimc_hash_signed<FieldT, M+1, 1>> w_hash;
-    pb_variable<FieldT> model_hash;
-
-    wsize.allocate(pb, "wsize");
-    w_selector.allocate(pb, M+1, "w_selector");
-    model_hash.allocate(pb, "model_hash");
-
-    w_size_selector.reset(new size_selector_gadget<FieldT, M+1>(
-        pb,
-        wsize,
-        w_selector,
-        "w_size_selector"));
-    w_size_selector->allocate();
-    
-    model.reset(new signed_vector<FieldT, M+1>(
-        pb,
-        M+1,
-        w_size_selector,
-        "modelcoefficients"));
-    model->allocate();
-    
-    w_hash.reset(new mimc_hash_signed<FieldT, M+1, 1>(
-        pb,
-        model,
-        model_hash,
-        "w_hash"));
-    w_hash->allocate();
-
-    pb.val(wsize) = M+1;
-    w_size_selector->generate_r1cs_witness();
-    // note that if size of coefficients is less than
-    // M+1, it will be resized in set_values.
-    model->set_values(coefficients);
-    model->generate_r1cs_witness();
-    w_hash->generate_r1cs_witness();
-    
-    // convert hash to mpz to hex string
-    mpz_t mhash;
-    mpz_init(mhash);
-    pb.val(model_hash).as_bigint().to_mpz(mhash);
-    mpz_class hash(mhash);
-    mpz_clear(mhash);
-    return hash.get_str(16);
+    if (dhandle->categorical_states.empty()) {
+        std::cout << data_handle_file << " has no chain states, generate it with --gen-handle --appendable" << std::endl;
+        return nullptr;
+    }
+    const size_t nrows = dhandle->categorical_states[0].size_ + dataset->nrows;
+    if (nrows > N) {
+        std::cout << "Data handles cover at most " << N << " rows, "
+            << data_handle_file << " has " << dhandle->categorical_states[0].size_ << std::endl;
+        return nullptr;
+    }
+
+    // values of the handle columns, dummy columns hold the
+    // level of "NA" or 0
+    const size_t n_cat = dhandle->categorical_features.size();
+    const size_t n_int = dhandle->integer_features.size();
+    const std::vector<uint64_t> zeros(dataset->nrows, 0);
+    std::vector<std::vector<uint64_t>> cat_features(n_cat);
+    std::vector<column_span<uint64_t>> int_features(n_int, column_span<uint64_t>(zeros));
+    auto& catColNames = dataset->catColNames;
+    for(size_t i=0; i < n_cat; ++i) {
+        auto& colName = std::get<0>(dhandle->categorical_features[i]);
+        auto it = std::find(catColNames.begin(), catColNames.end(), colName);
+        if (it == catColNames.end() && colName == "Dummy") {
+            cat_features[i].assign(dataset->nrows, 1);
+            continue;
+        } else if (it == catColNames.end()) {
+            std::cout << "Column " << colName << " of " << data_handle_file << " is missing" << std::endl;
+            return nullptr;
+        }
+
+        const size_t j = it - catColNames.begin();
+        levels_lookup lookup(dhandle->levels_map[colName]);
+        std::vector<std::string> unseen;
+        cat_features[i] = lookup_levels(
+            dataset->categorical_codes[j], dataset->categorical_dict[j], lookup, unseen);
+        if (!unseen.empty()) {
+            std::cout << "Column " << colName << ": level '" << unseen[0] << "' is not in " 
+                << data_handle_file << ", generate the data handle of the whole dataset" << std::endl;
+            return nullptr;
+        }
+    }
+
+    auto& intColNames = dataset->intColNames;
+    for(size_t i=0; i < n_int; ++i) {
+        auto& colName = std::get<0>(dhandle->integer_features[i]);
+        auto it = std::find(intColNames.begin(), intColNames.end(), colName);
+        if (it != intColNames.end())
+            int_features[i] = dataset->integer_matrix[it - intColNames.begin()];
+        else if (colName != "Dummy") {
+            std::cout << "Column " << colName << " of " << data_handle_file << " is missing" << std::endl;
+            return nullptr;
+        }
+    }
+
+    std::shared_ptr<DataHandle> extended(new DataHandle(*dhandle));
+    if (extended->has_row_root) {
+        auto columns = column_spans(cat_features);
+        columns.insert(columns.end(), int_features.begin(), int_features.end());
+        for(auto& leaf : compute_row_leaves(columns, dataset->nrows))
+            extended->row_state.append(leaf);
+        extended->row_root = extended->row_state.root();
+    }
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for(size_t i=0; i < n_cat + n_int; ++i) {
+        if (i < n_cat) {
+            auto& state = extended->categorical_states[i];
+            state.append(cat_features[i].data(), cat_features[i].size());
+            std::get<1>(extended->categorical_features[i]) = state.hash();
+        } else {
+            // short columns are 0-extended, as compute_data_handle does
+            auto& state = extended->integer_states[i-n_cat];
+            auto& column = int_features[i-n_cat];
+            state.append(column.data(), column.size());
+            state.append(zeros.data(), dataset->nrows - column.size());
+            std::get<1>(extended->integer_features[i-n_cat]) = state.hash();
+        }
+    }
+    return extended;
 }
 
-// generate proving and verification keys for
-// model provenance gadget
-void generate_model_provenance_keys(
-    const std::string& pkey_file, 
-    const std::string& vkey_file)
+//! magic string at the start of a dataset cache
+const char dataset_cache_magic[8] = {'T', 'A', 'I', 'D', 'S', 'C', '0', '5'};
+
+// Dataset cache layout (see binary_writer):
+//  magic, nrows
+//  categorical columns: count, then name, dictionary, codes
+//  integer columns: count, then name, values
+//  numeric columns: count, then name, values
+//  data handle: as in a binary data handle, without magic
+
+/**
+ * Writes the dataset together with its data handle, so that
+ * later commands can skip parsing and hashing the data.
+ * @return false in case of failure
+ */
+bool write_dataset_cache(
+    const std::string& file,
+    const Dataset& ds,
+    const DataHandle& dhandle)
+{
+    std::ofstream out(file, std::ios::binary);
+    if (!out) return false;
+    binary_writer writer(out);
+
+    writer.write_magic(dataset_cache_magic);
+    writer.write_u64(ds.nrows);
+
+    writer.write_u64(ds.n_cat_features);
+    for(size_t i=0; i < ds.n_cat_features; ++i) {
+        writer.write_string(ds.catColNames[i]);
+        writer.write_u64(ds.categorical_dict[i].size());
+        for(auto& value : ds.categorical_dict[i])
+            writer.write_string(value);
+        writer.write_array(ds.categorical_codes[i]);
+    }
+
+    writer.write_u64(ds.n_integer_features);
+    for(size_t i=0; i < ds.n_integer_features; ++i) {
+        writer.write_string(ds.intColNames[i]);
+        writer.write_array(ds.integer_matrix[i]);
+    }
+
+    writer.write_u64(ds.n_numeric_features);
+    for(size_t i=0; i < ds.n_numeric_features; ++i) {
+        writer.write_string(ds.numColNames[i]);
+        writer.write_array(ds.numeric_matrix[i]);
+    }
+
+    write_data_handle_body(writer, dhandle);
+
+    out.close();
+    return !out.fail();
+}
+
+/**
+ * Checks whether file starts with the dataset cache magic
+ */
+bool is_dataset_cache(const std::string& file)
+{
+    std::ifstream in(file, std::ios::binary);
+    char magic[sizeof(dataset_cache_magic)] = {0};
+    in.read(magic, sizeof(magic));
+    return in.good() && (std::memcmp(magic, dataset_cache_magic, sizeof(magic)) == 0);
+}
+
+/**
+ * Reads a dataset cache written by write_dataset_cache.
+ * The file is memory mapped and its columns are copied out
+ * in bulk. If sd is given, the cached columns must have the
+ * kinds that the schema assigns to them. The curve parameters
+ * must be initialized, the hashes are read into field elements.
+ * @input dhandle set to the cached data handle
+ * @return pointer to Dataset object, nullptr in case of failure
+ */
+std::shared_ptr<Dataset>
+read_dataset_cache(
+    const std::string& file,
+    std::shared_ptr<SchemaDescriptor> sd,
+    std::shared_ptr<DataHandle>& dhandle)
+{
+    auto t0 = libff::get_nsec_time();
+    mapped_file mfile;
+    if (!mfile.open(file)) {
+        std::cout << "Unable to open " << file << std::endl;
+        return nullptr;
+    }
+
+    binary_reader reader(mfile.data(), mfile.data() + mfile.size());
+    if (!reader.check_magic(dataset_cache_magic)) {
+        std::cout << "Not a dataset cache: " << file << std::endl;
+        return nullptr;
+    }
+
+    std::shared_ptr<Dataset> ds(new Dataset());
+    ds->nrows = reader.read_u64();
+
+    // counts are bounded by the bytes left before they size anything:
+    // a categorical column takes at least three u64 (name length,
+    // dictionary size, code count), other columns two, and a
+    // dictionary entry one
+    ds->n_cat_features = reader.read_count(3 * sizeof(uint64_t));
+    for(size_t i=0; reader.ok() && i < ds->n_cat_features; ++i) {
+        ds->catColNames.emplace_back(reader.read_string());
+        std::vector<std::string> dict(reader.read_count(sizeof(uint64_t)));
+        for(size_t k=0; reader.ok() && k < dict.size(); ++k)
+            dict[k] = reader.read_string();
+        ds->categorical_dict.emplace_back(dict);
+        ds->categorical_codes.emplace_back();
+        reader.read_array(ds->categorical_codes.back());
+    }
+
+    ds->n_integer_features = reader.read_count(2 * sizeof(uint64_t));
+    for(size_t i=0; reader.ok() && i < ds->n_integer_features; ++i) {
+        ds->intColNames.emplace_back(reader.read_string());
+        ds->integer_matrix.emplace_back();
+        reader.read_array(ds->integer_matrix.back());
+    }
+
+    ds->n_numeric_features = reader.read_count(2 * sizeof(uint64_t));
+    for(size_t i=0; reader.ok() && i < ds->n_numeric_features; ++i) {
+        ds->numColNames.emplace_back(reader.read_string());
+        ds->numeric_matrix.emplace_back();
+        reader.read_array(ds->numeric_matrix.back());
+    }
+    ds->ncols = ds->n_cat_features + ds->n_integer_features + ds->n_numeric_features;
+
+    dhandle.reset(new DataHandle());
+    if (!read_data_handle_body(reader, *dhandle, true) || !reader.at_end()) {
+        std::cout << "Malformed dataset cache: " << file << std::endl;
+        return nullptr;
+    }
+
+    // every column must hold nrows values
+    bool consistent = true;
+    for(auto& col : ds->categorical_codes)
+        consistent = consistent && (col.size() == ds->nrows);
+    for(auto& col : ds->integer_matrix)
+        consistent = consistent && (col.size() == ds->nrows);
+    for(auto& col : ds->numeric_matrix)
+        consistent = consistent && (col.size() == ds->nrows);
+    for(size_t i=0; i < ds->n_cat_features; ++i)
+        for(auto code : ds->categorical_codes[i])
+            consistent = consistent && (code < ds->categorical_dict[i].size());
+    if (!consistent) {
+        std::cout << "Malformed dataset cache: " << file << std::endl;
+        return nullptr;
+    }
+
+    if (sd != nullptr) {
+        std::set<std::string> catSet(sd->categorical_features.begin(),
+            sd->categorical_features.end());
+        std::set<std::string> intSet(sd->integer_features.begin(),
+            sd->integer_features.end());
+        std::set<std::string> numSet(sd->numeric_features.begin(),
+            sd->numeric_features.end());
+        bool matches = true;
+        for(auto& colName : ds->catColNames)
+            matches = matches && catSet.count(colName);
+        for(auto& colName : ds->intColNames)
+            matches = matches && intSet.count(colName);
+        for(auto& colName : ds->numColNames)
+            matches = matches && numSet.count(colName);
+        if (!matches) {
+            std::cout << "Dataset cache " << file << " does not match the schema" << std::endl;
+            return nullptr;
+        }
+    }
+
+    auto t1 = libff::get_nsec_time();
+    std::cout << "Loaded dataset cache [ " << file << " ] Rows: [ " << ds->nrows 
+        << " ] Time: [ " << double(t1 - t0)/1e9 << " s ]" << std::endl;
+    return ds;
+}
+
+#ifdef WITH_ARROW
+/**
+ * read a dataset from an Arrow IPC (Feather V2) file, given the schema
+ * Columns are matched to the schema by field name, exactly as the
+ * header of a CSV file, and copied out of the mapped record batches.
+ * @input file path to data file
+ * @input sd the pointer to schema object
+ * @return pointer to Dataset object, nullptr in case of failure
+ */
+std::shared_ptr<Dataset>
+read_dataset_arrow(
+    const std::string& file,
+    std::shared_ptr<SchemaDescriptor> sd)
+{
+    std::shared_ptr<Dataset> ds(new Dataset());
+
+    std::set<std::string> catSet(sd->categorical_features.begin(),
+        sd->categorical_features.end());
+    std::set<std::string> intSet(sd->integer_features.begin(),
+        sd->integer_features.end());
+    std::set<std::string> numSet(sd->numeric_features.begin(),
+        sd->numeric_features.end());
+
+    auto t0 = libff::get_nsec_time();
+    arrow_dataset_reader reader;
+    if (!reader.open(file))
+        return nullptr;
+
+    std::vector<size_t> catCols, intCols, numCols;
+    std::set<std::string> found;
+    for(size_t j=0; j < reader.num_columns(); ++j) {
+        const std::string& colName = reader.column_name(j);
+        found.insert(colName);
+        if (catSet.count(colName)) {
+            catCols.emplace_back(j);
+            ds->catColNames.emplace_back(colName);
+        } else if (intSet.count(colName)) {
+            intCols.emplace_back(j);
+            ds->intColNames.emplace_back(colName);
+        } else if (numSet.count(colName)) {
+            numCols.emplace_back(j);
+            ds->numColNames.emplace_back(colName);
+        }
+    }
+    if (!check_schema_columns(*sd, found, file))
+        return nullptr;
+
+    ds->n_cat_features = catCols.size();
+    ds->n_integer_features = intCols.size();
+    ds->n_numeric_features = numCols.size();
+    ds->ncols = catCols.size() + intCols.size() + numCols.size();
+    ds->nrows = reader.num_rows();
+    ds->categorical_dict.resize(ds->n_cat_features);
+    ds->categorical_codes.resize(ds->n_cat_features);
+    ds->integer_matrix.resize(ds->n_integer_features);
+    ds->numeric_matrix.resize(ds->n_numeric_features);
+
+    for(size_t k=0; k < catCols.size(); ++k) {
+        string_dictionary dict;
+        if (!reader.read_categorical_column(catCols[k], dict, ds->categorical_codes[k]))
+            return nullptr;
+        if (dict.size() > max_categorical_levels) {
+            std::cout << "Column " << catCols[k]+1 << " (" << ds->catColNames[k] << "): more than " 
+                << max_categorical_levels << " distinct values" << std::endl;
+            return nullptr;
+        }
+        for(uint32_t code=0; code < dict.size(); ++code)
+            ds->categorical_dict[k].emplace_back(dict.str(code));
+    }
+    for(size_t k=0; k < intCols.size(); ++k) {
+        if (!reader.read_integer_column(intCols[k], ds->integer_matrix[k]))
+            return nullptr;
+        auto& col = ds->integer_matrix[k];
+        auto it = std::find_if(col.begin(), col.end(), 
+            [](uint64_t value) { return value > max_integer_value; });
+        if (it != col.end()) {
+            std::cout << "Row " << (it - col.begin()) + 1 << ", column " << intCols[k]+1 << " (" 
+                << ds->intColNames[k] << "): integer " << *it << " exceeds " 
+                << integer_bit_width << " bits" << std::endl;
+            return nullptr;
+        }
+    }
+    for(size_t k=0; k < numCols.size(); ++k)
+        if (!reader.read_numeric_column(numCols[k], ds->numeric_matrix[k]))
+            return nullptr;
+
+    auto t1 = libff::get_nsec_time();
+    std::cout << "Read Arrow [ " << file << " ] Rows: [ " << ds->nrows << " ] Time: [ " 
+        << double(t1 - t0) / 1e9 << "s ]" << std::endl;
+    return ds;
+}
+#endif
+
+/**
+ * Reads a single dataset file: a CSV file, an Arrow IPC / Feather V2
+ * file (builds with WITH_ARROW) or a dataset cache (see 
+ * --cache-dataset); binary formats are detected by their magic.
+ * @input dhandle set to the cached data handle for a cache, 
+ * nullptr for a CSV file
+ * @return pointer to Dataset object, nullptr in case of failure
+ */
+std::shared_ptr<Dataset>
+load_dataset_file(
+    const std::string& file,
+    std::shared_ptr<SchemaDescriptor> sd,
+    std::shared_ptr<DataHandle>& dhandle)
+{
+    dhandle = nullptr;
+    if (is_dataset_cache(file))
+        return read_dataset_cache(file, sd, dhandle);
+    if (is_arrow_file(file)) {
+#ifdef WITH_ARROW
+        return read_dataset_arrow(file, sd);
+#else
+        std::cout << "Built without Arrow support, cannot read " << file << std::endl;
+        return nullptr;
+#endif
+    }
+    return read_dataset(file, sd);
+}
+
+/**
+ * Concatenates the partitions of a dataset, in order
+ * Categorical values are re-interned into one dictionary per column,
+ * so codes, and the levels computed from them, are those a single
+ * file holding all rows would give. Partition columns are released
+ * as they are appended.
+ * @return pointer to Dataset object, nullptr if the partitions do not
+ * have the same columns or a column has too many distinct values
+ */
+std::shared_ptr<Dataset>
+concat_partitions(
+    const std::vector<std::string>& files,
+    std::vector<std::shared_ptr<Dataset>>& parts)
+{
+    const Dataset& first = *parts[0];
+    std::shared_ptr<Dataset> ds(new Dataset());
+    for(size_t p=1; p < parts.size(); ++p) {
+        if (parts[p]->catColNames != first.catColNames || 
+            parts[p]->intColNames != first.intColNames ||
+            parts[p]->numColNames != first.numColNames) {
+            std::cout << "Partition " << files[p] << " does not have the columns of " 
+                << files[0] << std::endl;
+            return nullptr;
+        }
+        ds->nrows += parts[p]->nrows;
+    }
+    ds->nrows += first.nrows;
+    ds->catColNames = first.catColNames;
+    ds->intColNames = first.intColNames;
+    ds->numColNames = first.numColNames;
+    ds->n_cat_features = first.n_cat_features;
+    ds->n_integer_features = first.n_integer_features;
+    ds->n_numeric_features = first.n_numeric_features;
+    ds->ncols = first.ncols;
+
+    ds->categorical_dict.resize(ds->n_cat_features);
+    ds->categorical_codes.resize(ds->n_cat_features);
+    for(size_t k=0; k < ds->n_cat_features; ++k) {
+        string_dictionary dict;
+        auto& codes = ds->categorical_codes[k];
+        codes.reserve(ds->nrows);
+        for(auto& part : parts) {
+            std::vector<uint32_t> remap(part->categorical_dict[k].size());
+            for(size_t c=0; c < remap.size(); ++c)
+                remap[c] = dict.intern(part->categorical_dict[k][c]);
+            for(auto code : part->categorical_codes[k])
+                codes.emplace_back(remap[code]);
+            std::vector<uint32_t>().swap(part->categorical_codes[k]);
+        }
+        if (dict.size() > max_categorical_levels) {
+            std::cout << "Column " << ds->catColNames[k] << ": more than " 
+                << max_categorical_levels << " distinct values across partitions" << std::endl;
+            return nullptr;
+        }
+        for(uint32_t code=0; code < dict.size(); ++code)
+            ds->categorical_dict[k].emplace_back(dict.str(code));
+    }
+
+    ds->integer_matrix.resize(ds->n_integer_features);
+    for(size_t k=0; k < ds->n_integer_features; ++k) {
+        ds->integer_matrix[k].reserve(ds->nrows);
+        for(auto& part : parts) {
+            auto& col = part->integer_matrix[k];
+            ds->integer_matrix[k].insert(ds->integer_matrix[k].end(), col.begin(), col.end());
+            std::vector<uint64_t>().swap(col);
+        }
+    }
+
+    ds->numeric_matrix.resize(ds->n_numeric_features);
+    for(size_t k=0; k < ds->n_numeric_features; ++k) {
+        ds->numeric_matrix[k].reserve(ds->nrows);
+        for(auto& part : parts) {
+            auto& col = part->numeric_matrix[k];
+            ds->numeric_matrix[k].insert(ds->numeric_matrix[k].end(), col.begin(), col.end());
+            std::vector<double>().swap(col);
+        }
+    }
+    return ds;
+}
+
+/**
+ * Reads a dataset given as a data file argument, which names either
+ * one file or several partitions (a glob, or @manifest listing them;
+ * see expand_partitions). Partitions are read in parallel and
+ * concatenated in the order they are listed, so the dataset, and the
+ * data handle computed from it, do not depend on how rows are split.
+ * @input dhandle set to the cached data handle for a single dataset 
+ * cache, nullptr otherwise
+ * @return pointer to Dataset object, nullptr in case of failure
+ */
+std::shared_ptr<Dataset>
+load_dataset(
+    const std::string& file,
+    std::shared_ptr<SchemaDescriptor> sd,
+    std::shared_ptr<DataHandle>& dhandle)
+{
+    dhandle = nullptr;
+    std::vector<std::string> files;
+    if (!expand_partitions(file, files))
+        return nullptr;
+    // dataset caches hold field elements; libff initializes its
+    // curve parameters without locking, so once, before the threads
+    snark_pp::init_public_params();
+    if (files.size() == 1)
+        return load_dataset_file(files[0], sd, dhandle);
+
+    // handles cached with partitions only describe the partition
+    auto t0 = libff::get_nsec_time();
+    std::vector<std::shared_ptr<Dataset>> parts(files.size());
+#ifdef MULTICORE
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(size_t i=0; i < files.size(); ++i) {
+        std::shared_ptr<DataHandle> partition_handle;
+        parts[i] = load_dataset_file(files[i], sd, partition_handle);
+    }
+
+    for(size_t i=0; i < files.size(); ++i) {
+        if (parts[i] == nullptr) {
+            std::cout << "Failed to read partition " << files[i] << std::endl;
+            return nullptr;
+        }
+    }
+
+    auto ds = concat_partitions(files, parts);
+    auto t1 = libff::get_nsec_time();
+    if (ds != nullptr)
+        std::cout << "Read [ " << files.size() << " ] partitions Rows: [ " << ds->nrows 
+            << " ] Time: [ " << double(t1 - t0) / 1e9 << " s ]" << std::endl;
+    return ds;
+}
+
+/**
+ * Encodes the categorical columns of an inference batch
+ * The levels are those of the source dataset, read from its data
+ * handle, so that a batch encodes values exactly as the training
+ * data did. Values that do not occur in the source dataset are
+ * reported and encoded as 0. Without a data handle, which only
+ * --verify-inference allows, the levels are computed from the batch
+ * itself. No hashing circuit is built.
+ * @input data_handle_file data handle of the source dataset, may be
+ * empty when verifying
+ * @input cat_features set to the level of every row, per column
+ * @return false if the data handle cannot be read or lacks a column
+ */
+bool encode_batch_levels(
+    const Dataset& ds,
+    const std::string& data_handle_file,
+    std::vector<std::vector<uint64_t>>& cat_features)
+{
+    cat_features.clear();
+    if (data_handle_file.empty()) {
+        std::cout << "No --data-handle given, levels are computed from the batch" << std::endl;
+        for(size_t i=0; i < ds.catColNames.size(); ++i) {
+            std::map<std::string, uint64_t> levels;
+            cat_features.emplace_back(encode_levels(
+                ds.categorical_codes[i], ds.categorical_dict[i], levels));
+        }
+        return true;
+    }
+
+    auto dhandle = read_data_handle(data_handle_file);
+    if (dhandle == nullptr)
+        return false;
+
+    for(size_t i=0; i < ds.catColNames.size(); ++i) {
+        auto& colName = ds.catColNames[i];
+        auto it = dhandle->levels_map.find(colName);
+        if (it == dhandle->levels_map.end()) {
+            std::cout << "Column " << colName << " has no levels in " << data_handle_file << std::endl;
+            return false;
+        }
+
+        levels_lookup lookup(it->second);
+        std::vector<std::string> unseen;
+        cat_features.emplace_back(lookup_levels(
+            ds.categorical_codes[i], ds.categorical_dict[i], lookup, unseen));
+        for(auto& value : unseen)
+            std::cout << "Column " << colName << ": unseen level '" << value 
+                << "' encoded as 0" << std::endl;
+    }
+    return true;
+}
+
+/**
+ * Coefficients of a model in the layout of the circuits.
+ * Models of at most M features are 0-padded to M+1 coefficients,
+ * wider ones to the features of their column groups. The offset
+ * goes last (W_M for narrow models), as integer_slot places the
+ * target of the data.
+ */
+std::vector<double> model_layout(const std::vector<double>& coefficients)
+{
+    const size_t n = coefficients.size();
+    const size_t groups = integer_column_groups(n);
+    const size_t features = M + groups * column_group_width;
+    std::vector<double> layout(features + 1, 0);
+    for(size_t k=0; k < n; ++k)
+        layout[integer_slot(k, n, features)] = coefficients[k];
+    return layout;
+}
+
+// native model hash of the width of G column groups
+struct model_hasher {
+    const std::vector<uint64_t>& signs;
+    const std::vector<uint64_t>& magnitudes;
+    FieldT hash;
+
+    model_hasher(const std::vector<uint64_t>& s, const std::vector<uint64_t>& m):
+        signs(s), magnitudes(m) {};
+
+    template<size_t G>
+    void run()
+    {
+        const size_t width = M + G * column_group_width + 1;
+        hash = mimc_hash_signed_values<FieldT, width, packing_model>(
+            signs.data(), magnitudes.data(), width);
+    }
+};
+
+/**
+ * Computes hash of a linear model
+ * A model is expressed as M+1 coefficients (for configured value M)
+ * i.e W_0, W_1,..., W_M. We use W_M as the offset term, instead of W_0
+ * Thus, the prediction for x_0,...x_{M-1} is W_0.x_0 + ... W_M
+ * Models of more than M features take the layout of model_layout.
+ * The hash is computed natively, as model_hash_gadget computes it
+ * (version model_hash_version), without building the circuit.
+ * @return "" if a coefficient does not fit in float_bit_width bits,
+ * or the model has more features than the column groups can hold
+ */
+std::string 
+compute_model_hash(const std::vector<double>& coefficients)
+{
+    snark_pp::init_public_params();
+
+    const size_t groups = integer_column_groups(coefficients.size());
+    if (groups > max_column_groups) {
+        std::cout << "Models have at most " << M + max_column_groups * column_group_width
+            << " features, the model has " << coefficients.size() - 1 << std::endl;
+        return "";
+    }
+
+    // fixed point as signed_vector::set_values
+    const auto layout = model_layout(coefficients);
+    std::vector<uint64_t> signs(layout.size(), 0), magnitudes(layout.size(), 0);
+    size_t bad = to_fixed_point<float_precision_safe>(
+        layout.data(), layout.size(), signs.data(), magnitudes.data(), float_bit_width);
+    if (bad != layout.size()) {
+        std::cout << "Coefficient " << layout[bad] << " exceeds " << float_bit_width 
+            << " bits at precision " << float_precision_safe << std::endl;
+        return "";
+    }
+    
+    model_hasher hasher(signs, magnitudes);
+    column_groups_dispatch<max_column_groups>::run(groups, hasher);
+    return field_to_hex(hasher.hash);
+}
+
+/**
+ * Key of a cache entry, "" if a part is missing (a file that could
+ * not be digested), so that such results are not cached
+ */
+std::string result_key(const std::vector<std::string>& parts)
+{
+    for(auto& part : parts)
+        if (part.empty())
+            return "";
+    return cache_key(parts);
+}
+
+/**
+ * Digest of a dataset given as schema and data file arguments, over
+ * the schema and every partition, in order
+ * @return "" if a file cannot be read
+ */
+std::string dataset_digest(const std::string& schema_file, const std::string& data_file)
+{
+    std::vector<std::string> files;
+    if (!expand_partitions(data_file, files))
+        return "";
+    std::vector<std::string> parts(1, sha256_file(schema_file));
+    for(auto& file : files)
+        parts.emplace_back(sha256_file(file));
+    return result_key(parts);
+}
+
+/**
+ * Fast counterpart of dataset_digest, over the fast hashes of the
+ * schema and the partitions (see fingerprint_index)
+ * @return "" if a file cannot be read
+ */
+std::string dataset_fast_digest(const std::string& schema_file, const std::string& data_file)
+{
+    std::vector<std::string> files;
+    if (!expand_partitions(data_file, files))
+        return "";
+    std::vector<std::string> parts(1, fast_hash_file(schema_file));
+    for(auto& file : files)
+        parts.emplace_back(fast_hash_file(file));
+    return result_key(parts);
+}
+
+// the sizes a circuit is instantiated with, in the keys of cached results
+std::string circuit_id(const std::string& name)
+{
+    return name + "/N" + std::to_string(N) + "/M" + std::to_string(M) +
+        "/C" + std::to_string(C) + "/B" + std::to_string(B) +
+        "/W" + std::to_string(column_group_width) + "/G" + std::to_string(max_column_groups);
+}
+
+/**
+ * Copies the cached value of key to output_file
+ * @return false without --cache-dir, or on a miss
+ */
+bool cache_fetch(const std::string& key, const std::string& output_file, const std::string& what)
+{
+    std::string value;
+    if (result_cache == nullptr || key.empty() || !result_cache->get(key, value))
+        return false;
+    if (!write_file_bytes(output_file, value))
+        return false;
+    std::cout << "Cache hit: [ " << what << " ] " << output_file << std::endl;
+    return true;
+}
+
+// stores the contents of output_file under key, with --cache-dir
+void cache_store(const std::string& key, const std::string& output_file)
+{
+    std::string value;
+    if (result_cache == nullptr || key.empty() || !read_file_bytes(output_file, value))
+        return;
+    if (!result_cache->put(key, value))
+        std::cout << "Failed to cache " << output_file << std::endl;
+}
+
+/**
+ * Hash of the model in model_file (see compute_model_hash), cached
+ * by the digests of the model and its schema with --cache-dir
+ * @return "" if the model cannot be read
+ */
+std::string model_hash_of(const std::string& model_file, const std::string& model_schema_file)
+{
+    const std::string key = result_key({"model-hash",
+        sha256_file(model_file), sha256_file(model_schema_file),
+        circuit_id("model-v" + std::to_string(model_hash_version))});
+    std::string model_hash;
+    if (result_cache != nullptr && !key.empty() && result_cache->get(key, model_hash))
+        return model_hash;
+
+    auto msd = read_schema_descriptor(model_schema_file);
+    if (msd == nullptr)
+        return "";
+    auto model = read_dataset(model_file, msd);
+    if (model == nullptr)
+        return "";
+    model_hash = compute_model_hash(model->numeric_matrix[0]);
+    if (result_cache != nullptr && !key.empty())
+        result_cache->put(key, model_hash);
+    return model_hash;
+}
+
+/**
+ * Path of the precomputed extension of a proving key
+ * i.e. model_prov.pk --> model_prov.ppk
+ */
+std::string precomputed_key_file(const std::string& pkey_file)
+{
+    auto pos = pkey_file.rfind(".pk");
+    if (pos == std::string::npos || pos + 3 != pkey_file.size())
+        return pkey_file + ".ppk";
+    return pkey_file.substr(0, pos) + ".ppk";
+}
+
+/**
+ * Runs the ppzksnark generator and streams the keys to disk.
+ * The proving key is written in binary form directly from the
+ * keypair (no serialized copy is buffered), the verification
+ * key in text form. The constraint system is released as soon
+ * as the generator has taken its own copy. The precomputed key of
+ * the previous proving key, if any, is removed.
+ * @input cs constraint system, cleared on return
+ */
+void generate_keys(
+    r1cs_constraint_system<FieldT>& cs,
+    const std::string& pkey_file,
+    const std::string& vkey_file)
+{
+    auto t0 = libff::get_nsec_time();
+    std::cout << "Constraints: [ " << cs.num_constraints() << " ] Variables: [ " 
+        << cs.num_variables() << " ]" << std::endl;
+    auto keypair = r1cs_ppzksnark_generator<snark_pp>(cs);
+    cs = r1cs_constraint_system<FieldT>();
+    auto t1 = libff::get_nsec_time();
+    std::cout << "Finished key generation: [ " << (t1 - t0)/1000000000 << " s ]" << std::endl;
+    std::cout << "Peak RSS: [ " << peak_rss_kb() << " KB ]" << std::endl;
+
+    std::ofstream ofile_pk(pkey_file, std::ios::binary);
+    if (!write_proving_key_binary<snark_pp>(ofile_pk, keypair.pk, new_proving_key_id())) {
+        std::cerr << "Failed to write proving key " << pkey_file << std::endl;
+        exit(1);
+    }
+    ofile_pk.close();
+    const std::string ppkey_file = precomputed_key_file(pkey_file);
+    if (std::remove(ppkey_file.c_str()) == 0)
+        std::cout << "Removed precomputed key of the previous proving key: [ " << ppkey_file << " ]" << std::endl;
+
+    std::ofstream ofile_vk(vkey_file);
+    ofile_vk << keypair.vk;
+    ofile_vk.close();
+
+    t0 = libff::get_nsec_time();
+    std::cout << "Finished writing keys: [ " << (t0 - t1)/1000000000 << " s ]" << std::endl;
+    std::cout << "Peak RSS: [ " << peak_rss_kb() << " KB ]" << std::endl;
+}
+
+/**
+ * Path of a key of the provenance circuit for the given hash
+ * mode and column groups, the chain keys of M features keep
+ * their original names
+ * @input ext pk, ppk or vk
+ * @input groups column groups, the keys of wider circuits are
+ * named by their features, e.g. model_prov_f52.pk
+ */
+std::string provenance_key_file(
+    const std::string& config_dir,
+    hash_mode mode,
+    const std::string& ext,
+    size_t groups = 0)
+{
+    std::string base = (mode == hash_mode::chain) ? "model_prov" : "model_prov_tree";
+    if (groups > 0)
+        base += "_f" + std::to_string(M + groups * column_group_width);
+    return config_dir + "/" + base + "." + ext;
+}
+
+// the provenance circuit with G column groups
+template<size_t G>
+using provenance_circuit = model_provenance_gadget<FieldT, N, C,
+    M + G * column_group_width, G, column_group_width>;
+
+// constraints of the provenance circuit of G column groups
+struct provenance_constraints {
+    hash_mode mode;
+    r1cs_constraint_system<FieldT> cs;
+
+    provenance_constraints(hash_mode m): mode(m) {};
+
+    template<size_t G>
+    void run()
+    {
+        protoboard<FieldT> pb;
+        provenance_circuit<G> provenance_gadget(pb, 0, "provenance_gadget", mode);
+        provenance_gadget.generate_r1cs_constraints();
+        cs = pb.get_constraint_system();
+    }
+};
+
+// generate proving and verification keys for
+// model provenance gadget, with the given column groups
+void generate_model_provenance_keys(
+    const std::string& pkey_file, 
+    const std::string& vkey_file,
+    hash_mode mode = hash_mode::chain,
+    size_t groups = 0)
+{
+    snark_pp::init_public_params();
+    // the protoboard is dropped before running the generator
+    provenance_constraints constraints(mode);
+    column_groups_dispatch<max_column_groups>::run(groups, constraints);
+
+    generate_keys(constraints.cs, pkey_file, vkey_file);
+}
+
+// generate proving and verification keys for
+// model inference gadget
+void generate_model_inference_keys(
+    const std::string& pkey_file, 
+    const std::string& vkey_file)
+{
+    snark_pp::init_public_params();
+    r1cs_constraint_system<FieldT> cs;
+    {
+        protoboard<FieldT> pb;
+        model_inference_gadget<FieldT, B, C, M> inference_gadget(pb, 9, "inference_gadget");
+        inference_gadget.generate_r1cs_constraints();
+        assert(pb.primary_input().size() == (B*M+B+2));
+        cs = pb.get_constraint_system();
+    }
+
+    generate_keys(cs, pkey_file, vkey_file);
+}
+
+/**
+ * Reports the size of a circuit and the evaluation domain
+ * libfqfft selects for its QAP (as in r1cs_to_qap), together
+ * with the number of constraints that can still be added
+ * before the domain reaches the next power of two.
+ */
+void analyze_circuit(
+    const std::string& name,
+    const r1cs_constraint_system<FieldT>& cs)
+{
+    // r1cs_to_qap adds one constraint per input plus one
+    const size_t required = cs.num_constraints() + cs.num_inputs() + 1;
+    size_t next_pow2 = 1;
+    while (next_pow2 < required)
+        next_pow2 <<= 1;
+
+    std::cout << "Circuit: [ " << name << " ]" << std::endl;
+    std::cout << "  Constraints: [ " << cs.num_constraints() << " ]" << std::endl;
+    std::cout << "  Variables: [ " << cs.num_variables() << " ] Inputs: [ " << cs.num_inputs() << " ]" << std::endl;
+    std::cout << "  Required domain size: [ " << required << " ]" << std::endl;
+
+    std::string domain_type = "none";
+    size_t domain_size = 0;
+    try {
+        auto domain = libfqfft::get_evaluation_domain<FieldT>(required);
+        domain_size = domain->m;
+        if (std::dynamic_pointer_cast<libfqfft::basic_radix2_domain<FieldT>>(domain))
+            domain_type = "basic_radix2";
+        else if (std::dynamic_pointer_cast<libfqfft::extended_radix2_domain<FieldT>>(domain))
+            domain_type = "extended_radix2";
+        else if (std::dynamic_pointer_cast<libfqfft::step_radix2_domain<FieldT>>(domain))
+            domain_type = "step_radix2";
+        else if (std::dynamic_pointer_cast<libfqfft::arithmetic_sequence_domain<FieldT>>(domain))
+            domain_type = "arithmetic_sequence";
+        else if (std::dynamic_pointer_cast<libfqfft::geometric_sequence_domain<FieldT>>(domain))
+            domain_type = "geometric_sequence";
+    } catch (const libfqfft::DomainSizeException& e) {
+        std::cout << "  No evaluation domain: [ " << e.what() << " ]" << std::endl;
+    }
+
+    std::cout << "  Domain: [ " << domain_type << " ] Size: [ " << domain_size << " ]" << std::endl;
+    std::cout << "  Next power of two: [ " << next_pow2 << " ] Headroom: [ "
+        << (next_pow2 - required) << " constraints ]" << std::endl;
+}
+
+/**
+ * Runs analyze_circuit on every circuit instance of the tool
+ */
+void analyze_circuits()
+{
+    snark_pp::init_public_params();
+    // every instance of the provenance circuit: both hash modes, and
+    // every number of column groups, each adding column_group_width
+    // features
+    for(auto mode : {hash_mode::chain, hash_mode::tree}) {
+        for(size_t groups=0; groups <= max_column_groups; ++groups) {
+            std::string name = (mode == hash_mode::tree) ? "provenance-tree" : "provenance";
+            if (groups > 0)
+                name += "-f" + std::to_string(M + groups * column_group_width);
+            provenance_constraints constraints(mode);
+            column_groups_dispatch<max_column_groups>::run(groups, constraints);
+            analyze_circuit(name, constraints.cs);
+        }
+    }
+    {
+        // membership of one row in the row tree of a data handle
+        protoboard<FieldT> pb;
+        pb_variable<FieldT> root, index;
+        root.allocate(pb, "row_root");
+        index.allocate(pb, "row_index");
+        pb.set_input_sizes(2);
+        pb_variable_array<FieldT> row;
+        row.allocate(pb, C + M+1, "row");
+        mimc_row_membership<FieldT, C + M+1, row_tree_depth> membership(pb, row, root, index, "row_membership");
+        membership.allocate();
+        membership.generate_r1cs_constraints();
+        analyze_circuit("row-membership", pb.get_constraint_system());
+    }
+    {
+        protoboard<FieldT> pb;
+        model_inference_gadget<FieldT, B, C, M> inference_gadget(pb, 9, "inference_gadget");
+        inference_gadget.generate_r1cs_constraints();
+        analyze_circuit("inference", pb.get_constraint_system());
+    }
+    {
+        protoboard<FieldT> pb;
+        model_hash_gadget<FieldT, M> hash_gadget(pb, "model_hash_gadget");
+        hash_gadget.generate_r1cs_constraints();
+        analyze_circuit("model-hash", pb.get_constraint_system());
+    }
+}
+
+/**
+ * Builds the fixed-base tables for the multi-exponentiations
+ * of the prover and stores them next to the proving key.
+ * @input pkey_file path to the proving key
+ * @input window window size in bits for the tables
+ */
+void precompute_proving_key(
+    const std::string& pkey_file,
+    size_t window)
+{
+    snark_pp::init_public_params();
+
+    r1cs_ppzksnark_proving_key<snark_pp> pkey;
+    std::string key_id;
+    if (!read_proving_key<snark_pp>(pkey_file, pkey, key_id)) {
+        std::cerr << "Failed to read proving key " << pkey_file << std::endl;
+        exit(1);
+    }
+    if (key_id.empty()) {
+        std::cerr << "Proving key " << pkey_file << " has no id, generate it again with --gen-keys" << std::endl;
+        exit(1);
+    }
+
+    r1cs_ppzksnark_precomputed_key<snark_pp> ppkey;
+    ppkey.build(pkey, window, key_id);
+
+    auto ppkey_file = precomputed_key_file(pkey_file);
+    if (!ppkey.write(ppkey_file)) {
+        std::cerr << "Failed to write precomputed key " << ppkey_file << std::endl;
+        exit(1);
+    }
+    std::cout << "Precomputed key: [ " << ppkey_file << " ]" << std::endl;
+}
+
+/**
+ * Generates the proof for the assignment on the protoboard.
+ * If a precomputed key (see --precompute-key) of the proving key
+ * exists next to it, it is memory mapped and answers the 
+ * multi-exponentiations of the prover. Otherwise they are
+ * computed by the engine selected with --msm.
+ */
+r1cs_ppzksnark_proof<snark_pp>
+generate_proof(
+    const std::string& pkey_file,
+    protoboard<FieldT>& pb)
+{
+    r1cs_ppzksnark_proving_key<snark_pp> pkey;
+    std::string key_id;
+    auto t0 = libff::get_nsec_time();
+    std::cout << "Reading proving key: [ " << t0/1000000000 << " ]" << std::endl;
+    if (!read_proving_key<snark_pp>(pkey_file, pkey, key_id)) {
+        std::cerr << "Failed to read proving key " << pkey_file << std::endl;
+        exit(1);
+    }
+    t0 = libff::get_nsec_time();
+    std::cout << "Finished deserializing proving key: [ " << t0/1000000000 << " ]" << std::endl;
+
+    r1cs_ppzksnark_proof<snark_pp> proof;
+    // tables are used only if built from this key, the id read
+    // with the key and the query sizes must match
+    const std::string ppkey_file = precomputed_key_file(pkey_file);
+    r1cs_ppzksnark_precomputed_key<snark_pp> ppkey;
+    if (!key_id.empty() && std::ifstream(ppkey_file).good() && ppkey.load(ppkey_file, pkey, key_id)) {
+        std::cout << "Using precomputed key: [ " << ppkey_file << " ]" << std::endl;
+        proof = r1cs_ppzksnark_prover_precomputed<snark_pp>(pkey, ppkey, pb.primary_input(), pb.auxiliary_input());
+    } else if (prover_msm == msm_engine::pippenger) {
+        proof = r1cs_ppzksnark_prover_pippenger<snark_pp>(pkey, pb.primary_input(), pb.auxiliary_input());
+    } else {
+        proof = r1cs_ppzksnark_prover<snark_pp>(pkey, pb.primary_input(), pb.auxiliary_input());
+    }
+    t0 = libff::get_nsec_time();
+    std::cout << "Finished proof generation: [ " << t0/1000000000 << " ]" << std::endl;
+    return proof;
+}
+
+
+/**
+ * Times the multi-exponentiations of the prover with the libff
+ * and pippenger engines on the queries of a proving key, using
+ * random scalars, and checks that both engines agree.
+ * @input pkey_file path to the proving key
+ */
+void bench_msm(const std::string& pkey_file)
 {
+    typedef libff::G1<snark_pp> G1;
+
     snark_pp::init_public_params();
-    protoboard<FieldT> pb;
+    r1cs_ppzksnark_proving_key<snark_pp> pkey;
+    if (!read_proving_key<snark_pp>(pkey_file, pkey)) {
+        std::cerr << "Failed to read proving key " << pkey_file << std::endl;
+        exit(1);
+    }
 
-    model_provenance_gadget<FieldT, N, C, M> provenance_gadget(pb, 0, "provenance_gaadget");
-    provenance_gadget.generate_r1cs_constraints();
-    
-    auto retval = r1cs_ppzksnark_generator<snark_pp>(pb.get_constraint_system());
-    
-    std::ofstream ofile_pk(pkey_file);
-    std::ofstream ofile_vk(vkey_file);
-    
-    ofile_pk << retval.pk;
-    ofile_vk << retval.vk;
+#ifdef MULTICORE
+    const size_t chunks = omp_get_max_threads();
+#else
+    const size_t chunks = 1;
+#endif
 
-    ofile_pk.close();
-    ofile_vk.close();
-    
+    // the prover uses num_variables scalars for the A, B, C and K
+    // queries and degree+1 for the H query
+    const size_t num_vars = pkey.constraint_system.num_variables();
+    const size_t num_h = pkey.H_query.size();
+    std::vector<FieldT> abc(num_vars), h(num_h);
+    for(auto& x : abc) x = FieldT::random_element();
+    for(auto& x : h) x = FieldT::random_element();
+
+    std::cout << "Key: [ " << pkey_file << " ] Variables: [ " << num_vars 
+        << " ] H terms: [ " << num_h << " ] Threads: [ " << chunks << " ]" << std::endl;
+
+    auto t0 = libff::get_nsec_time();
+    auto a_libff = kc_multi_exp_with_mixed_addition<G1, G1, FieldT, libff::multi_exp_method_bos_coster>(
+        pkey.A_query, 1, 1+num_vars, abc.begin(), abc.end(), chunks);
+    auto t1 = libff::get_nsec_time();
+    auto a_pippenger = pippenger_kc_multi_exp<G1, G1, FieldT>(
+        pkey.A_query, 1, 1+num_vars, abc.begin(), chunks);
+    auto t2 = libff::get_nsec_time();
+    std::cout << "A-query: libff [ " << (t1 - t0)/1000000 << " ms ] pippenger [ " 
+        << (t2 - t1)/1000000 << " ms ] match [ " << (a_libff == a_pippenger) << " ]" << std::endl;
+
+    t0 = libff::get_nsec_time();
+    auto h_libff = libff::multi_exp<G1, FieldT, libff::multi_exp_method_BDLO12>(
+        pkey.H_query.begin(), pkey.H_query.end(), h.begin(), h.end(), chunks);
+    t1 = libff::get_nsec_time();
+    auto h_pippenger = pippenger_multi_exp<G1, FieldT>(
+        pkey.H_query.begin(), h.begin(), num_h, chunks);
+    t2 = libff::get_nsec_time();
+    std::cout << "H-query: libff [ " << (t1 - t0)/1000000 << " ms ] pippenger [ " 
+        << (t2 - t1)/1000000 << " ms ] match [ " << (h_libff == h_pippenger) << " ]" << std::endl;
+
+    if (!(a_libff == a_pippenger) || !(h_libff == h_pippenger)) {
+        std::cerr << "Multi-exponentiation engines disagree" << std::endl;
+        exit(1);
+    }
 }
 
-// generate proving and verification keys for
-// model inference gadget
-void generate_model_inference_keys(
-    const std::string& pkey_file, 
-    const std::string& vkey_file)
+/**
+ * Reads a proof from file, in the binary (base64) or the
+ * legacy text encoding
+ */
+bool read_proof(
+    const std::string& proof_file,
+    r1cs_ppzksnark_proof<snark_pp>& proof)
+{
+    std::ifstream pfile(proof_file);
+    if (!pfile) return false;
+    std::stringstream buffer;
+    buffer << pfile.rdbuf();
+    return decode_proof<snark_pp>(buffer.str(), proof);
+}
+
+/**
+ * Compares the computations of the column hashes of a data handle
+ * on N rows of random values, in rows per second: the witness of
+ * the data_source gadget, mimc_column_hasher one column per thread,
+ * and mimc_hash_columns. The witness is timed apart from allocating
+ * the gadget, and the peak RSS is printed after it, so that changes
+ * to the cipher witness can be compared on their own.
+ * @input mode structure of the column hashes
+ */
+void bench_hash(hash_mode mode)
 {
     snark_pp::init_public_params();
-    protoboard<FieldT> pb;
+    std::mt19937_64 rng(42);
+    std::vector<std::vector<uint64_t>> cat_columns(C, std::vector<uint64_t>(N));
+    std::vector<std::vector<uint64_t>> int_columns(M+1, std::vector<uint64_t>(N));
+    for(auto& column : cat_columns)
+        for(auto& v : column) v = 1 + rng() % max_categorical_levels;
+    for(auto& column : int_columns)
+        for(auto& v : column) v = rng() & ((uint64_t(1) << integer_bit_width) - 1);
+    const auto cat_spans = column_spans(cat_columns);
+    const auto int_spans = column_spans(int_columns);
+
+#ifdef MULTICORE
+    const size_t threads = omp_get_max_threads();
+#else
+    const size_t threads = 1;
+#endif
+    std::cout << "Rows: [ " << N << " ] Columns: [ " << C + M+1 << " ] Mode: [ "
+        << ((mode == hash_mode::chain) ? "chain" : "tree") << " ] Threads: [ " << threads << " ]" << std::endl;
+
+    auto report = [](const std::string& name, uint64_t t0, uint64_t t1) {
+        const double secs = double(t1 - t0) / 1e9;
+        std::cout << name << ": [ " << secs << " s ] [ " << ((secs > 0) ? N / secs : 0) << " rows/s ]" << std::endl;
+    };
 
-    model_inference_gadget<FieldT, B, C, M> inference_gadget(pb, 9, "inference_gadget");
-    inference_gadget.generate_r1cs_constraints();
-    assert(pb.primary_input().size() == (B*M+B+2));
-    
-    auto retval = r1cs_ppzksnark_generator<snark_pp>(pb.get_constraint_system());
-    
-    std::ofstream ofile_pk(pkey_file);
-    std::ofstream ofile_vk(vkey_file);
-    
-    ofile_pk << retval.pk;
-    ofile_vk << retval.vk;
+    auto t0 = libff::get_nsec_time();
+    std::vector<FieldT> circuit;
+    {
+        protoboard<FieldT> pb;
+        data_source<FieldT, N, C, M+1> ds(pb, N, "data-source", mode);
+        ds.allocate();
+        ds.set_values(cat_spans, int_spans);
+        auto tw = libff::get_nsec_time();
+        report("Circuit allocation", t0, tw);
+        ds.generate_r1cs_witness();
+        report("Circuit witness", tw, libff::get_nsec_time());
+        std::cout << "Peak RSS: [ " << peak_rss_kb() << " KB ]" << std::endl;
+        circuit = ds.cHashes_;
+        circuit.insert(circuit.end(), ds.iHashes_.begin(), ds.iHashes_.end());
+    }
+    auto t1 = libff::get_nsec_time();
+
+    std::vector<FieldT> scalar(C + M+1);
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for(size_t i=0; i < C + M+1; ++i) {
+        if (i < C) {
+            DataHandle::cat_state_t state(mode);
+            state.append(cat_columns[i].data(), N);
+            scalar[i] = state.hash();
+        } else {
+            DataHandle::int_state_t state(mode);
+            state.append(int_columns[i-C].data(), N);
+            scalar[i] = state.hash();
+        }
+    }
+    auto t2 = libff::get_nsec_time();
+    report("Native, column per thread", t1, t2);
 
-    ofile_pk.close();
-    ofile_vk.close();
+    auto lanes = mimc_hash_columns<FieldT, N, packing_categorical>(cat_spans, N, mode);
+    auto int_lanes = mimc_hash_columns<FieldT, N, packing_integer>(int_spans, N, mode);
+    lanes.insert(lanes.end(), int_lanes.begin(), int_lanes.end());
+    auto t3 = libff::get_nsec_time();
+    report("Native, " + std::to_string(mimc_lane_count) + " lanes", t2, t3);
+
+    std::cout << "Hashes match: [ " << ((circuit == scalar) && (circuit == lanes)) << " ]" << std::endl;
 }
 
+// witness and proof of the provenance circuit of G column groups
+struct provenance_prover {
+    const std::string& pkey_file;
+    size_t nrows;
+    const std::vector<column_span<uint64_t>>& cat_features;
+    const std::vector<column_span<uint64_t>>& int_features;
+    const std::vector<column_span<uint64_t>>& target;
+    const std::vector<double>& model_coefficients;
+    r1cs_ppzksnark_proof<snark_pp> proof;
+    FieldT R2;
+
+    provenance_prover(
+        const std::string& pkey,
+        size_t rows,
+        const std::vector<column_span<uint64_t>>& cat,
+        const std::vector<column_span<uint64_t>>& integer,
+        const std::vector<column_span<uint64_t>>& tgt,
+        const std::vector<double>& model):
+        pkey_file(pkey), nrows(rows), cat_features(cat), int_features(integer),
+        target(tgt), model_coefficients(model) {};
+
+    template<size_t G>
+    void run()
+    {
+        protoboard<FieldT> pb;
+        provenance_circuit<G> provenance_gadget(pb, nrows, "provenance_gadget", data_hash_mode);
+        provenance_gadget.generate_r1cs_constraints();
+        auto t0 = libff::get_nsec_time();
+        provenance_gadget.generate_r1cs_witness(
+            cat_features, int_features, target, model_coefficients);
+        auto t1 = libff::get_nsec_time();
+        std::cout << "Witness generation: [ " << double(t1 - t0) / 1e9 << " s ] Peak RSS: [ " 
+            << peak_rss_kb() << " KB ]" << std::endl;
+
+        std::cout << "R2: " << pb.val(provenance_gadget.R2_) << std::endl;
+        print_protoboard_info(pb);
+        assert(pb.is_satisfied());
+        R2 = pb.val(provenance_gadget.R2_);
+
+        // Generating proof
+        proof = generate_proof(pkey_file, pb);
+    }
+};
 
 /**
  * This function generates proof of performance
@@ -569,6 +2558,9 @@ void generate_model_inference_keys(
  * columns.
  * (2) Categorical columns explicitly do not take part in prediction,
  * if desired, they must be encoded to numeric columns. 
+ * (3) Datasets of more than M features are proved by the circuit of
+ * their column groups, with the model in the layout of model_layout;
+ * pkey_file is the key of that circuit.
  */
 void generate_performance_proof(
     const std::string& pkey_file,
@@ -579,11 +2571,14 @@ void generate_performance_proof(
     const std::string& output_file)
 {
     snark_pp::init_public_params();
-    protoboard<FieldT> pb;
 
-    (void) pkey_file;
     auto sc_data = read_schema_descriptor(data_schema_file);
-    auto ds = read_dataset(data_file, sc_data);
+    std::shared_ptr<DataHandle> dhandle;
+    auto ds = load_dataset(data_file, sc_data, dhandle);
+    if (ds == nullptr) {
+        std::cerr << "Failed to read dataset " << data_file << std::endl;
+        exit(1);
+    }
    
     // view model as dataset with one numeric column
     auto sc_model = read_schema_descriptor(model_schema_file);
@@ -591,60 +2586,58 @@ void generate_performance_proof(
 
     // generate datahandle. Note that datahandle is returned
     // for extended dataset with C categorical features and
-    // M+1 integer features.
-    auto dhandle = compute_data_handle(ds);
+    // M+1 integer features, and the column groups beyond them.
+    if (dhandle == nullptr || dhandle->version != uint64_t(data_hash_mode))
+        dhandle = compute_data_handle(ds, false, data_hash_mode, data_hash_engine);
+    if (dhandle == nullptr) {
+        std::cerr << "Failed to compute data handle" << std::endl;
+        exit(1);
+    }
+
+    const size_t groups = integer_column_groups(ds->integer_matrix.size());
+    const size_t features = M + groups * column_group_width;
+    const auto model_coefficients = model_layout(m_coeff->numeric_matrix[0]);
+    if (model_coefficients.size() != features + 1) {
+        std::cerr << "The model has " << m_coeff->numeric_matrix[0].size() - 1 << " features, the circuit of "
+            << data_file << " has " << features << std::endl;
+        exit(1);
+    }
     
-    std::vector<std::vector<uint64_t>> cat_features, int_features, target;
-    std::vector<double> model_coefficients = m_coeff->numeric_matrix[0];
+    std::vector<std::vector<uint64_t>> cat_levels;
 
     // convert categorical columns to numeric columns using the
     // levels map
     for(size_t i=0; i < ds->catColNames.size(); ++i) {
-        auto col = ds->categorical_matrix[i];
         auto colName = ds->catColNames[i];
-        cat_features.emplace_back(apply_levels(col, dhandle->levels_map[colName]));
+        cat_levels.emplace_back(apply_levels(
+            ds->categorical_codes[i], ds->categorical_dict[i], dhandle->levels_map[colName]));
     }
 
-    // regard last but one integer columns of the (original) dataset as features
-    for(size_t i=0; i < ds->intColNames.size() - 1; ++i)
-         int_features.emplace_back(ds->integer_matrix[i]);
+    // the gadgets read the columns in place, missing columns
+    // and rows past the end of a column are 0
+    auto cat_features = column_spans(cat_levels);
+    cat_features.resize(C);
 
-    cat_features.resize(C, std::vector<uint64_t>(N, 0));
-    int_features.resize(M, std::vector<uint64_t>(N, 0));
+    // regard last but one integer columns of the (original) dataset as features
+    std::vector<column_span<uint64_t>> int_features(
+        ds->integer_matrix.begin(), ds->integer_matrix.end() - 1);
+    int_features.resize(features);
 
     // regard the last integer column of dataset as the target variable
-    target.emplace_back(ds->integer_matrix[ds->intColNames.size() - 1]);
+    std::vector<column_span<uint64_t>> target(1, ds->integer_matrix.back());
     
-    model_provenance_gadget<FieldT, N, C, M> provenance_gadget(pb, ds->nrows, "provenance_gadget");
-    provenance_gadget.generate_r1cs_constraints();
-    provenance_gadget.generate_r1cs_witness(
-        cat_features, int_features, target, model_coefficients);
-
-    std::cout << "R2: " << pb.val(provenance_gadget.R2_) << std::endl;
-    print_protoboard_info(pb);
-    assert(pb.is_satisfied());
-
-    // Generating proof
-    r1cs_ppzksnark_proving_key<snark_pp> pkey;
-    auto t0 = libff::get_nsec_time();
-    std::cout << "Reading proving key: [ " << t0/1000000000 << " ]" << std::endl;
-    std::ifstream ifile(pkey_file);
-    ifile >> pkey;
-    t0 = libff::get_nsec_time();
-    std::cout << "Finished deserializing proving key: [ " << t0/1000000000 << " ]" << std::endl;
-    auto proof = r1cs_ppzksnark_prover<snark_pp>(pkey, pb.primary_input(), pb.auxiliary_input());
-    t0 = libff::get_nsec_time();
-    std::cout << "Finished proof generation: [ " << t0/1000000000 << " ]" << std::endl;
+    provenance_prover prover(pkey_file, ds->nrows, cat_features, int_features, target, model_coefficients);
+    column_groups_dispatch<max_column_groups>::run(groups, prover);
 
     // Write the proof to file 
     std::ofstream ofile(output_file);
-    std::stringstream proofstr;
-    proofstr << proof;
+    auto proofstr = encode_proof(prover.proof, output_proof_format);
 
     YAML::Emitter yout;
     yout << YAML::BeginMap;
-    yout << YAML::Key << "R2" << YAML::Value << double(pb.val(provenance_gadget.R2_).as_ulong())/float_precision_safe;
-    yout << YAML::Key << "Proof" << YAML::Value << proofstr.str();
+    yout << YAML::Key << "R2" << YAML::Value << double(prover.R2.as_ulong())/float_precision_safe;
+    yout << YAML::Key << "ModelHashVersion" << YAML::Value << model_hash_version;
+    yout << YAML::Key << "Proof" << YAML::Value << proofstr;
     yout << YAML::EndMap;
 
     ofile << yout.c_str();
@@ -672,6 +2665,7 @@ generate_inference_proof(
     const std::string& data_file,
     const std::string& model_schema_file,
     const std::string& model_file,
+    const std::string& data_handle_file,
     const std::string& output_file)
 {
     snark_pp::init_public_params();
@@ -679,69 +2673,83 @@ generate_inference_proof(
 
     (void) pkey_file;
     auto sc_data = read_schema_descriptor(data_schema_file);
-    auto ds = read_dataset(data_file, sc_data);
+    // a cached handle describes the batch, not the source dataset
+    std::shared_ptr<DataHandle> batch_handle;
+    auto ds = load_dataset(data_file, sc_data, batch_handle);
+    if (ds == nullptr) {
+        std::cerr << "Failed to read dataset " << data_file << std::endl;
+        exit(1);
+    }
     std::cout << ds->nrows << " " << ds->ncols << std::endl; 
     // view model as dataset with one numeric column
     auto sc_model = read_schema_descriptor(model_schema_file);
     auto m_coeff = read_dataset(model_file, sc_model);
     
-    std::vector<std::vector<uint64_t>> cat_features, int_features;
-    std::vector<double> model_coefficients = m_coeff->numeric_matrix[0];
+    std::vector<std::vector<uint64_t>> cat_levels;
+    if (m_coeff->numeric_matrix[0].size() > M+1) {
+        std::cerr << "Inference proofs take models of at most " << M << " features, the model has "
+            << m_coeff->numeric_matrix[0].size() - 1 << std::endl;
+        exit(1);
+    }
+    // the offset is W_M, as in the model hash
+    const auto model_coefficients = model_layout(m_coeff->numeric_matrix[0]);
 
-    auto dhandle = compute_data_handle(ds);
     // convert categorical columns to numeric columns using the
-    // levels map
-    for(size_t i=0; i < ds->catColNames.size(); ++i) {
-        auto col = ds->categorical_matrix[i];
-        auto colName = ds->catColNames[i];
-        cat_features.emplace_back(apply_levels(col, dhandle->levels_map[colName]));
+    // levels map of the source dataset
+    if (data_handle_file.empty()) {
+        std::cerr << "Inference proofs need the data handle of the source dataset" << std::endl;
+        exit(1);
+    }
+    if (!encode_batch_levels(*ds, data_handle_file, cat_levels)) {
+        std::cerr << "Failed to encode the batch" << std::endl;
+        exit(1);
     }
 
-    // regard all integer columns as features
-    for(size_t i=0; i < ds->intColNames.size(); ++i)
-         int_features.emplace_back(ds->integer_matrix[i]);
-
-    // suitably extend the matrices
-    cat_features.resize(C, std::vector<uint64_t>(B, 0));
-    int_features.resize(M, std::vector<uint64_t>(B, 0));
+    // regard all integer columns as features, the gadgets read
+    // the columns in place and 0-extend them
+    auto cat_features = column_spans(cat_levels);
+    auto int_features = column_spans(ds->integer_matrix);
+    cat_features.resize(C);
+    int_features.resize(M);
     
     model_inference_gadget<FieldT, B, C, M> inference_gadget(pb, ds->nrows, "inference_gadget");
     inference_gadget.generate_r1cs_constraints();
+    auto t0 = libff::get_nsec_time();
     inference_gadget.generate_r1cs_witness(
         cat_features, int_features, model_coefficients);
+    auto t1 = libff::get_nsec_time();
+    std::cout << "Witness generation: [ " << double(t1 - t0) / 1e9 << " s ] Peak RSS: [ " 
+        << peak_rss_kb() << " KB ]" << std::endl;
 
     print_protoboard_info(pb);
     assert(pb.is_satisfied());
     assert(pb.primary_input().size() == (B*M+B+2));
 
     // Generating proof
-    r1cs_ppzksnark_proving_key<snark_pp> pkey;
-    auto t0 = libff::get_nsec_time();
-    std::cout << "Reading proving key: [ " << t0/1000000000 << " ]" << std::endl;
-    std::ifstream ifile(pkey_file);
-    ifile >> pkey;
-    t0 = libff::get_nsec_time();
-    std::cout << "Finished deserializing proving key: [ " << t0/1000000000 << " ]" << std::endl;
-    auto proof = r1cs_ppzksnark_prover<snark_pp>(pkey, pb.primary_input(), pb.auxiliary_input());
-    t0 = libff::get_nsec_time();
-    std::cout << "Finished proof generation: [ " << t0/1000000000 << " ]" << std::endl;
+    auto proof = generate_proof(pkey_file, pb);
     // Write the proof to file 
     std::ofstream ofile(output_file);
-    std::stringstream proofstr;
-    proofstr << proof;
+    auto proofstr = encode_proof(proof, output_proof_format);
 
-    std::vector<double> scores;
+    // the scores are signed, read them off the (s,v) pairs of z
+    // rather than from their field encoding
+    std::vector<uint64_t> signs(B), magnitudes(B);
     for(size_t i=0; i < B; ++i) {
-        scores.emplace_back(double(pb.primary_input()[B*M+i].as_ulong())/float_precision_safe);
+        signs[i] = inference_gadget.z_->contents_->ivVec[i].sign_;
+        magnitudes[i] = inference_gadget.z_->contents_->ivVec[i].value_;
     }
+    std::vector<double> scores(B);
+    from_fixed_point(signs.data(), magnitudes.data(), B, float_precision_safe, scores.data());
 
-    auto model_hash = compute_model_hash(model_coefficients);
+    // the circuit has hashed the model already
+    auto model_hash = field_to_hex(pb.val(inference_gadget.model_hash_));
     YAML::Emitter yout;
     yout << YAML::BeginMap;
     yout << YAML::Key << "ModelHash" << YAML::Value << model_hash;
+    yout << YAML::Key << "ModelHashVersion" << YAML::Value << model_hash_version;
     yout << YAML::Key << "Predictions";
     yout << YAML::Value << scores;
-    yout << YAML::Key << "Proof" << YAML::Value << proofstr.str();
+    yout << YAML::Key << "Proof" << YAML::Value << proofstr;
     yout << YAML::EndMap;
 
     ofile << yout.c_str();
@@ -751,14 +2759,16 @@ generate_inference_proof(
 
 /**
  * Verify the provenance of linear model performance claim
- * on a dataset. 
+ * on a dataset. The verification key is that of the hash mode
+ * and the integer column groups of the data handle.
+ * @input config_dir directory of the verification keys
  * @input data_handle_file path to datahandle descriptor file
  * @input model_hash hash of the linear model
  * @input R2 Rsquared accuracy claimed on the dataset
  * @input proof_file path to file containing the proof
  */
 bool verify_model_provenance_proof(
-    const std::string& vkey_file,           // verification key file
+    const std::string& config_dir,          // verification key directory
     const std::string& data_handle_file,    // data handle for data
     const std::string& model_hash,          // hash of the model
     const double R2,                        // claimed performance
@@ -767,23 +2777,33 @@ bool verify_model_provenance_proof(
     snark_pp::init_public_params();
     protoboard<FieldT> pb;
 
-    auto dhandle = read_data_handle(data_handle_file);
+    // only the column hashes are public inputs, skip the levels
+    auto t0 = libff::get_nsec_time();
+    auto dhandle = read_data_handle(data_handle_file, false);
+    if (dhandle == nullptr)
+        return false;
+    auto t1 = libff::get_nsec_time();
+    std::cout << "Data handle load: [ " << double(t1 - t0) / 1e9 << " s ]" << std::endl;
+    hash_mode mode;
+    (void) hash_mode_of_version(dhandle->version, mode);
+    const size_t groups = dhandle->integer_groups.size();
+    if (dhandle->categorical_features.size() != C || dhandle->integer_features.size() != M+1 ||
+        groups > max_column_groups) {
+        std::cout << data_handle_file << " does not have the columns of a provenance circuit" << std::endl;
+        return false;
+    }
+    const std::string vkey_file = provenance_key_file(config_dir, mode, "vk", groups);
+    std::cout << "Hash mode: [ " << ((mode == hash_mode::chain) ? "chain" : "tree") << " ] Features: [ "
+        << M + groups * column_group_width << " ]" << std::endl;
     std::vector<FieldT> catHashes, intHashes;
     uint64_t intR2 = (R2 * float_precision_safe);
-    // read the column hashes
-    for(size_t i=0; i < dhandle->categorical_features.size(); ++i) {
-        auto col_hash = std::get<1>(dhandle->categorical_features[i]);
-        mpz_class cHash(col_hash, 16);
-        FieldT hash(libff::bigint<FieldT::num_limbs>(cHash.get_mpz_t()));
-        catHashes.emplace_back(hash);
-    }
-
-    for(size_t i=0; i < dhandle->integer_features.size(); ++i) {
-        auto col_hash = std::get<1>(dhandle->integer_features[i]);
-        mpz_class iHash(col_hash, 16);
-        FieldT hash(libff::bigint<FieldT::num_limbs>(iHash.get_mpz_t()));
-        intHashes.emplace_back(hash);
-    }
+    for(auto& tup : dhandle->categorical_features)
+        catHashes.emplace_back(std::get<1>(tup));
+    for(auto& tup : dhandle->integer_features)
+        intHashes.emplace_back(std::get<1>(tup));
+    // the categorical groups are not read by the circuit
+    for(auto& group : dhandle->integer_groups)
+        intHashes.emplace_back(std::get<1>(group));
     // convert model hash to field element
     mpz_class mHash(model_hash, 16); // 16 is the base
     FieldT hash(libff::bigint<FieldT::num_limbs>(mHash.get_mpz_t()));
@@ -800,8 +2820,10 @@ bool verify_model_provenance_proof(
     ifile.close();
     
     r1cs_ppzksnark_proof<snark_pp> proof;
-    std::ifstream pfile(proof_file);
-    pfile >> proof;
+    if (!read_proof(proof_file, proof)) {
+        std::cout << "Malformed proof in " << proof_file << std::endl;
+        return false;
+    }
     
     bool ret = r1cs_ppzksnark_verifier_strong_IC<snark_pp>(vkey, primary_input, proof);
     std::string status = (ret)?"OK":"FAIL";
@@ -816,57 +2838,57 @@ bool verify_inference_proof(
     const std::string& scores_schema_file,
     const std::string& scores_file,
     const std::string& model_hash,
+    const std::string& data_handle_file,
     const std::string& proof_file)
 {
     snark_pp::init_public_params();
     protoboard<FieldT> pb;
 
     auto sc_data = read_schema_descriptor(data_schema_file);
-    auto ds = read_dataset(data_file, sc_data);
+    // a cached handle describes the batch, not the source dataset
+    std::shared_ptr<DataHandle> batch_handle;
+    auto ds = load_dataset(data_file, sc_data, batch_handle);
+    if (ds == nullptr) {
+        std::cerr << "Failed to read dataset " << data_file << std::endl;
+        exit(1);
+    }
     std::cout << ds->nrows << " " << ds->ncols << std::endl; 
     
     auto sc_scores = read_schema_descriptor(scores_schema_file);
     auto scores = read_dataset(scores_file, sc_scores);
     std::cout << scores->nrows << " " << scores->ncols << std::endl;
 
-    std::vector<std::vector<uint64_t>> cat_features, int_features;
-    std::vector<double> scores_vec;
-
-    auto dhandle = compute_data_handle(ds);
-    // convert categorical columns to numeric columns using the
-    // levels map
-    for(size_t i=0; i < ds->catColNames.size(); ++i) {
-        auto col = ds->categorical_matrix[i];
-        auto colName = ds->catColNames[i];
-        auto col1 = apply_levels(col, dhandle->levels_map[colName]);
-        col1.resize(B, 0);
-        cat_features.emplace_back(col1);
-    }
-
-    // regard all integer columns as features
-    for(size_t i=0; i < ds->intColNames.size(); ++i) {
-        auto col = ds->integer_matrix[i];
-        col.resize(B, 0);
-        int_features.emplace_back(col);
+    // categorical columns are not part of the statement, they are
+    // encoded only to report levels unseen in the source dataset
+    std::vector<std::vector<uint64_t>> cat_levels;
+    if (!encode_batch_levels(*ds, data_handle_file, cat_levels)) {
+        std::cout << "Failed to encode the batch" << std::endl;
+        return false;
     }
 
-    // suitably extend the matrices
-    cat_features.resize(C, std::vector<uint64_t>(B, 0));
-    int_features.resize(M, std::vector<uint64_t>(B, 0));
+    // regard all integer columns as features, read in place
+    // and 0-extended to B rows and M columns
+    auto int_features = column_spans(ds->integer_matrix);
+    int_features.resize(M);
 
     // read the scores
-    scores_vec = scores->numeric_matrix[0];
-    scores_vec.resize(B, 0);
+    const std::vector<double>& scores_vec = scores->numeric_matrix[0];
     
     std::vector<FieldT> primary_input;
     for(size_t i=0; i < B; ++i)
         for(size_t j=0; j < M; ++j)
-            primary_input.emplace_back(int_features[j][i]);
-
-    for(size_t i=0; i < B; ++i) {
-        uint64_t sval = scores_vec[i] * float_precision_safe;
-        primary_input.emplace_back(sval);
+            primary_input.emplace_back(int_features[j].get(i));
+
+    // scores enter as (1-2s).v, rounded as the prover rounds them
+    std::vector<uint64_t> signs, magnitudes;
+    size_t bad = to_fixed_point<float_precision_safe>(
+        scores_vec, B, signs, magnitudes, float_bit_width);
+    if (bad != B) {
+        std::cout << "Prediction " << scores_vec[bad] << " at row " << bad + 1 
+            << " is out of range" << std::endl;
+        return false;
     }
+    fixed_point_to_field(signs.data(), magnitudes.data(), B, primary_input);
 
     // convert hash string to FieldT element
     mpz_class mHash(model_hash, 16);
@@ -882,8 +2904,10 @@ bool verify_inference_proof(
     ifile.close();
     
     r1cs_ppzksnark_proof<snark_pp> proof;
-    std::ifstream pfile(proof_file);
-    pfile >> proof;
+    if (!read_proof(proof_file, proof)) {
+        std::cout << "Malformed proof in " << proof_file << std::endl;
+        return false;
+    }
 
     assert(primary_input.size() == (B*M+B+2));
 
@@ -892,39 +2916,260 @@ bool verify_inference_proof(
     std::cout << "Proof Verification Status [ " << status << " ]" << std::endl;
     return ret;
 }
+
+/**
+ * Reads the value of a numeric option, exits with a usage error
+ * unless it is a non-negative integer
+ * @input name option name, without the leading --
+ */
+uint64_t numeric_option(std::map<std::string, std::string>& opts, const std::string& name)
+{
+    const std::string& text = opts[name];
+    uint64_t value;
+    if (!parse_uint64(text.data(), text.size(), value)) {
+        std::cerr << "--" << name << " takes a non-negative integer, not '" << text << "'" << std::endl;
+        exit(1);
+    }
+    return value;
+}
    
 void process_options(std::map<std::string, std::string>& opts)
 {
 
     const std::string config_dir = getenv("TRUSTED_AI_CRYPTO_CONFIG_DIR");
-    const std::string pkey_prov_file = config_dir + "/model_prov.pk";
-    const std::string vkey_prov_file = config_dir + "/model_prov.vk";
+    if (opts.find("hash-mode") != opts.end()) {
+        if (!parse_hash_mode(opts["hash-mode"], data_hash_mode)) {
+            std::cerr << "Unknown hash mode " << opts["hash-mode"] << std::endl;
+            exit(1);
+        }
+    }
+    // the keys of the provenance circuit for --features features
+    size_t key_groups = 0;
+    if (opts.find("features") != opts.end()) {
+        const uint64_t features = numeric_option(opts, "features");
+        if (features > M + max_column_groups * column_group_width) {
+            std::cerr << "--features is at most " << M + max_column_groups * column_group_width << std::endl;
+            exit(1);
+        }
+        key_groups = integer_column_groups(features + 1);
+    }
+    const std::string pkey_prov_file = provenance_key_file(config_dir, data_hash_mode, "pk", key_groups);
+    const std::string vkey_prov_file = provenance_key_file(config_dir, data_hash_mode, "vk", key_groups);
     const std::string pkey_inf_file = config_dir + "/model_inf.pk";
     const std::string vkey_inf_file = config_dir + "/model_inf.vk";
     const std::string model_schema_file = config_dir + "/model_schema.yaml";
     const std::string scores_schema_file = config_dir + "/scores_schema.yaml";
     
+    if (opts.find("threads") != opts.end()) {
+#ifdef MULTICORE
+        const uint64_t threads = numeric_option(opts, "threads");
+        if (threads == 0 || threads > uint64_t(std::numeric_limits<int>::max())) {
+            std::cerr << "--threads must be positive" << std::endl;
+            exit(1);
+        }
+        omp_set_num_threads(int(threads));
+#else
+        std::cout << "Built without MULTICORE, ignoring --threads" << std::endl;
+#endif
+    }
+
+    if (opts.find("msm") != opts.end()) {
+        if (!parse_msm_engine(opts["msm"], prover_msm)) {
+            std::cerr << "Unknown multi-exponentiation engine " << opts["msm"] << std::endl;
+            exit(1);
+        }
+    }
+
+    if (opts.find("proof-format") != opts.end()) {
+        if (!parse_proof_format(opts["proof-format"], output_proof_format)) {
+            std::cerr << "Unknown proof format " << opts["proof-format"] << std::endl;
+            exit(1);
+        }
+    }
+
+    if (opts.find("hash-engine") != opts.end()) {
+        if (!parse_hash_engine(opts["hash-engine"], data_hash_engine)) {
+            std::cerr << "Unknown hash engine " << opts["hash-engine"] << std::endl;
+            exit(1);
+        }
+    }
+
+    if (opts.find("cache-dir") != opts.end()) {
+        uint64_t cache_mb = default_cache_mb;
+        if (opts.find("cache-size") != opts.end())
+            cache_mb = numeric_option(opts, "cache-size");
+        if (cache_mb > (std::numeric_limits<uint64_t>::max() >> 20)) {
+            std::cerr << "--cache-size is too large" << std::endl;
+            exit(1);
+        }
+        result_cache.reset(new content_cache(opts["cache-dir"], cache_mb << 20));
+    }
+
+    if (opts.find("prune-cache") != opts.end()) {
+        if (result_cache == nullptr) {
+            std::cerr << "--prune-cache needs --cache-dir" << std::endl;
+            exit(1);
+        }
+        std::cout << "Cache size: [ " << result_cache->evict() << " bytes ]" << std::endl;
+        return;
+    }
+
     if (opts.find("gen-handle") != opts.end()) {
         // generate data handle
         auto data_schema_file = opts["data-schema"];
         auto data_file = opts["data-file"];
         auto output_file = opts["output"];
         std::cout << data_schema_file << " " << data_file << " " << output_file << std::endl;
+        const bool appendable = (opts.find("appendable") != opts.end());
+        // everything but the data a handle depends on
+        auto handle_key = [&](const std::string& digest) {
+            return result_key({"data-handle", digest,
+                std::to_string(uint64_t(data_hash_mode)),
+                appendable ? "appendable" : "sealed",
+                is_yaml_file(output_file) ? "yaml" : "binary",
+                circuit_id("data-source")});
+        };
+        const std::string key = (result_cache == nullptr) ? "" :
+            handle_key(dataset_digest(data_schema_file, data_file));
+        if (cache_fetch(key, output_file, "data handle"))
+            return;
+
+        // a handle generated from the same bytes is copied, the data
+        // is only read to fingerprint it
+        std::shared_ptr<fingerprint_index> handle_index;
+        fingerprint fp;
+        if (opts.find("handle-index") != opts.end()) {
+            handle_index.reset(new fingerprint_index(opts["handle-index"]));
+            fp.fast = handle_key(dataset_fast_digest(data_schema_file, data_file));
+            std::string found = fp.fast.empty() ? "" : handle_index->find(fp.fast, [&]() {
+                return fp.sha256 = handle_key(dataset_digest(data_schema_file, data_file));
+            });
+            std::string handle;
+            if (!found.empty() && read_file_bytes(found, handle) && write_file_bytes(output_file, handle)) {
+                std::cout << "Fingerprint match: [ " << found << " ] " << output_file << std::endl;
+                if (!handle_index->add(fp, output_file))
+                    std::cout << "Failed to index " << output_file << std::endl;
+                cache_store(key, output_file);
+                return;
+            }
+        }
         auto sd = read_schema_descriptor(data_schema_file);
         if (sd == nullptr) {
-            std::cerr << "Failed to read schema";
+            std::cerr << "Failed to read schema" << std::endl;
             exit(1);
         }
-        auto ds = read_dataset(data_file, sd);
+        std::shared_ptr<DataHandle> dhandle;
+        auto ds = load_dataset(data_file, sd, dhandle);
         if (ds == nullptr) {
             std::cerr << "Failed to read dataset";
             exit(1);
         }
 
-        auto dhandle = compute_data_handle(ds);
-        std::ofstream outfile(output_file);
-        dhandle->print(outfile);
-        outfile.close();
+        // a cached handle has no chain states
+        if (dhandle == nullptr || (appendable && dhandle->categorical_states.empty()) ||
+            dhandle->version != uint64_t(data_hash_mode))
+            dhandle = compute_data_handle(ds, appendable, data_hash_mode, data_hash_engine);
+        if (dhandle == nullptr) {
+            std::cerr << "Failed to compute data handle" << std::endl;
+            exit(1);
+        }
+        if (!save_data_handle(output_file, *dhandle)) {
+            std::cerr << "Failed to write data handle " << output_file << std::endl;
+            exit(1);
+        }
+        cache_store(key, output_file);
+        if (handle_index != nullptr) {
+            if (fp.sha256.empty())
+                fp.sha256 = handle_key(dataset_digest(data_schema_file, data_file));
+            if (fp.fast.empty() || fp.sha256.empty() || !handle_index->add(fp, output_file))
+                std::cout << "Failed to index " << output_file << std::endl;
+        }
+        return;
+    }
+
+    if (opts.find("append-rows") != opts.end()) {
+        // extend an appendable data handle with new rows
+        auto data_handle_file = opts["data-handle"];
+        auto data_schema_file = opts["data-schema"];
+        auto data_file = opts["data-file"];
+        auto output_file = opts["output"];
+        auto dhandle = read_data_handle(data_handle_file);
+        if (dhandle == nullptr) {
+            std::cerr << "Failed to read data handle " << data_handle_file << std::endl;
+            exit(1);
+        }
+        auto sd = read_schema_descriptor(data_schema_file);
+        if (sd == nullptr) {
+            std::cerr << "Failed to read schema" << std::endl;
+            exit(1);
+        }
+        std::shared_ptr<DataHandle> batch_handle;
+        auto ds = load_dataset(data_file, sd, batch_handle);
+        if (ds == nullptr) {
+            std::cerr << "Failed to read dataset";
+            exit(1);
+        }
+
+        auto t0 = libff::get_nsec_time();
+        auto extended = append_data_handle(dhandle, ds, data_handle_file);
+        if (extended == nullptr)
+            exit(1);
+        auto t1 = libff::get_nsec_time();
+        std::cout << "Appended " << ds->nrows << " rows: [ " << double(t1 - t0) / 1e9 << " s ]" << std::endl;
+        if (!save_data_handle(output_file, *extended)) {
+            std::cerr << "Failed to write data handle " << output_file << std::endl;
+            exit(1);
+        }
+        return;
+    }
+
+    if (opts.find("export-handle") != opts.end()) {
+        // binary data handle to YAML, for humans
+        auto data_handle_file = opts["data-handle"];
+        auto output_file = opts["output"];
+        auto dhandle = read_data_handle(data_handle_file);
+        if (dhandle == nullptr) {
+            std::cerr << "Failed to read data handle " << data_handle_file << std::endl;
+            exit(1);
+        }
+        if (output_file.empty()) {
+            dhandle->print(std::cout);
+            std::cout << std::endl;
+        } else {
+            std::ofstream outfile(output_file);
+            dhandle->print(outfile);
+            outfile.close();
+        }
+        return;
+    }
+
+    if (opts.find("cache-dataset") != opts.end()) {
+        // parse and hash the data once, for later commands
+        auto data_schema_file = opts["data-schema"];
+        auto data_file = opts["data-file"];
+        auto output_file = opts["output"];
+        auto sd = read_schema_descriptor(data_schema_file);
+        if (sd == nullptr) {
+            std::cerr << "Failed to read schema" << std::endl;
+            exit(1);
+        }
+        std::shared_ptr<DataHandle> dhandle;
+        auto ds = load_dataset(data_file, sd, dhandle);
+        if (ds == nullptr) {
+            std::cerr << "Failed to read dataset";
+            exit(1);
+        }
+
+        if (dhandle == nullptr || dhandle->version != uint64_t(data_hash_mode))
+            dhandle = compute_data_handle(ds, false, data_hash_mode, data_hash_engine);
+        if (dhandle == nullptr) {
+            std::cerr << "Failed to compute data handle" << std::endl;
+            exit(1);
+        }
+        if (!write_dataset_cache(output_file, *ds, *dhandle)) {
+            std::cerr << "Failed to write dataset cache " << output_file << std::endl;
+            exit(1);
+        }
         return;
     }
 
@@ -932,17 +3177,11 @@ void process_options(std::map<std::string, std::string>& opts)
         // compute model hash
         auto model_file = opts["model-file"];
         auto output_file = opts["output"];
-        auto msd = read_schema_descriptor(model_schema_file);
-        if (msd == nullptr) {
-            std::cerr << "Failed to read model schema:";
-            exit(1);
-        }
-        auto model = read_dataset(model_file, msd);
-        if (model == nullptr) {
+        auto model_hash = model_hash_of(model_file, model_schema_file);
+        if (model_hash.empty()) {
             std::cerr << "Failed to read the model";
             exit(1);
         }
-        auto model_hash = compute_model_hash(model->numeric_matrix[0]);
         std::ofstream outfile(output_file);
         outfile << model_hash;
         outfile.close();
@@ -955,12 +3194,28 @@ void process_options(std::map<std::string, std::string>& opts)
         auto data_file = opts["data-file"];
         auto model_file = opts["model-file"];
         auto output_file = opts["output"];
-        generate_performance_proof(pkey_prov_file,
+        // the keys of the circuit of the column groups of the data
+        auto sd = read_schema_descriptor(data_schema_file);
+        if (sd == nullptr) {
+            std::cerr << "Failed to read schema" << std::endl;
+            exit(1);
+        }
+        const size_t groups = integer_column_groups(sd->integer_features.size());
+        const std::string key = (result_cache == nullptr) ? "" : result_key({"performance-proof",
+            dataset_digest(data_schema_file, data_file),
+            model_hash_of(model_file, model_schema_file),
+            circuit_id("provenance-" + std::to_string(uint64_t(data_hash_mode))),
+            sha256_file(provenance_key_file(config_dir, data_hash_mode, "vk", groups)),
+            std::to_string(int(output_proof_format))});
+        if (cache_fetch(key, output_file, "performance proof"))
+            return;
+        generate_performance_proof(provenance_key_file(config_dir, data_hash_mode, "pk", groups),
             data_schema_file,
             data_file,
             model_schema_file,
             model_file,
             output_file);
+        cache_store(key, output_file);
         return; 
     } 
     
@@ -969,13 +3224,71 @@ void process_options(std::map<std::string, std::string>& opts)
         auto data_schema_file = opts["data-schema"];
         auto data_file = opts["data-file"];
         auto model_file = opts["model-file"];
+        auto data_handle_file = opts["data-handle"];
         auto output_file = opts["output"];
+        // the batch is encoded with the levels of the source dataset,
+        // levels computed from the batch would not match the model
+        if (data_handle_file.empty()) {
+            std::cerr << "--prove-inference needs --data-handle of the source dataset" << std::endl;
+            exit(1);
+        }
+        const std::string key = (result_cache == nullptr) ? "" : result_key({"inference-proof",
+            dataset_digest(data_schema_file, data_file),
+            model_hash_of(model_file, model_schema_file),
+            sha256_file(data_handle_file),
+            circuit_id("inference"),
+            sha256_file(vkey_inf_file),
+            std::to_string(int(output_proof_format))});
+        if (cache_fetch(key, output_file, "inference proof"))
+            return;
         (void) generate_inference_proof(pkey_inf_file,
             data_schema_file,
             data_file,
             model_schema_file,
             model_file,
+            data_handle_file,
             output_file);
+        cache_store(key, output_file);
+        return;
+    }
+
+    if (opts.find("analyze-circuit") != opts.end()) {
+        analyze_circuits();
+        return;
+    }
+
+    if (opts.find("bench-msm") != opts.end()) {
+        bench_msm(pkey_prov_file);
+        bench_msm(pkey_inf_file);
+        return;
+    }
+
+    if (opts.find("bench-hash") != opts.end()) {
+        bench_hash(data_hash_mode);
+        return;
+    }
+
+    if (opts.find("gen-keys") != opts.end()) {
+        // generate proving and verification keys
+        generate_model_provenance_keys(pkey_prov_file, vkey_prov_file, data_hash_mode, key_groups);
+        // inference takes models of M features only
+        if (key_groups == 0)
+            generate_model_inference_keys(pkey_inf_file, vkey_inf_file);
+        return;
+    }
+
+    if (opts.find("precompute-key") != opts.end()) {
+        // extend proving keys with fixed-base tables
+        size_t window = fixed_base_window;
+        if (opts.find("window") != opts.end())
+            window = numeric_option(opts, "window");
+        if (window == 0 || window > 24) {
+            std::cerr << "Window must be between 1 and 24 bits" << std::endl;
+            exit(1);
+        }
+        precompute_proving_key(pkey_prov_file, window);
+        if (key_groups == 0)
+            precompute_proving_key(pkey_inf_file, window);
         return;
     }
 
@@ -985,7 +3298,7 @@ void process_options(std::map<std::string, std::string>& opts)
         double R2 = std::stod(opts["r2"], NULL);
         auto proof_file = opts["proof"]; 
         bool ret = verify_model_provenance_proof(
-            vkey_prov_file,
+            config_dir,
             data_handle_file,
             model_hash,
             R2,
@@ -1003,6 +3316,7 @@ void process_options(std::map<std::string, std::string>& opts)
         auto data_file = opts["data-file"];
         auto scores_file = opts["predictions"];
         auto model_hash = opts["model-hash"];
+        auto data_handle_file = opts["data-handle"];
         auto proof_file = opts["proof"];
 
         bool ret = verify_inference_proof(
@@ -1012,6 +3326,7 @@ void process_options(std::map<std::string, std::string>& opts)
             scores_schema_file,
             scores_file,
             model_hash,
+            data_handle_file,
             proof_file);
 
         if (ret)
@@ -1027,16 +3342,71 @@ void print_usage()
 {
     std::cout << "Usage patterns for the utility:" << std::endl;
     std::cout << "Generate Datahandle:" << std::endl;
-    std::cout << "--gen-handle --data-schema <data_schema_file> --data-file <data_file> --output <data_handle_file>" << std::endl << std::endl;
+    std::cout << "--gen-handle --data-schema <data_schema_file> --data-file <data_file> --output <data_handle_file> [--appendable]" << std::endl;
+    std::cout << "The data handle is binary, unless <data_handle_file> ends in .yaml or .yml." << std::endl;
+    std::cout << "--appendable keeps the state of the column hashes, which includes the last rows" << std::endl;
+    std::cout << "of the data: keep appendable data handles private, and publish their YAML export." << std::endl;
+    std::cout << "Data handles of at most " << N << " rows also commit to each row (RowRoot), so that a" << std::endl;
+    std::cout << "circuit can show that a row belongs to the data with " << row_tree_depth << " hashes (see --analyze-circuit)." << std::endl;
+    std::cout << "The last integer column is the target. Columns beyond " << C << " categorical and " << M 
+        << " integer features are committed in groups" << std::endl;
+    std::cout << "of " << column_group_width << " (CategoricalGroups, IntegerGroups), up to " 
+        << M + max_column_groups * column_group_width << " integer features; such handles have no RowRoot." << std::endl;
+    std::cout << "--handle-index <index_file> fingerprints the data (fast hash, confirmed by SHA-256) and copies" << std::endl;
+    std::cout << "an indexed handle of identical data instead of hashing it; new handles are indexed, with" << std::endl;
+    std::cout << "their fingerprint in <data_handle_file>.fp." << std::endl << std::endl;
+    std::cout << "Export Datahandle as YAML:" << std::endl;
+    std::cout << "--export-handle --data-handle <data_handle_file> [--output <yaml_file>]" << std::endl << std::endl;
+    std::cout << "Append Rows to Datahandle:" << std::endl;
+    std::cout << "--append-rows --data-handle <appendable_data_handle> --data-schema <data_schema_file> --data-file <new_rows_file> --output <data_handle_file>" << std::endl;
+    std::cout << "Only the new rows are hashed, the result is the data handle of all rows." << std::endl << std::endl;
     std::cout << "Compute Model Hash:" << std::endl;
-    std::cout << "--compute-hash --model-file <model_file> --output <model_hash_file>" << std::endl << std::endl;
+    std::cout << "--compute-hash --model-file <model_file> --output <model_hash_file>" << std::endl;
+    std::cout << "Model hashes are version " << model_hash_version << ": " << packing_model 
+        << " coefficients with their signs per field element." << std::endl << std::endl;
     std::cout << "Prove Model Performance:" << std::endl;
     std::cout << "--prove-performance --data-schema <data_schema_file> --data-file <data_file> --model-file <model_file> --output <proof_file>" << std::endl << std::endl;
     std::cout << "Prove Model Inference:" << std::endl;
-    std::cout << "--prove-inference --data-schema <batch_schema> --data-file <batch_file> --model-file <model_file> --output <predictions_proof_file>" << std::endl << std::endl;
+    std::cout << "--prove-inference --data-schema <batch_schema> --data-file <batch_file> --model-file <model_file> --data-handle <data_handle_file> --output <predictions_proof_file>" << std::endl << std::endl;
     std::cout << "Verify Performance:" << std::endl;
     std::cout << "--verify-performance --data-handle <data_handle_file> --model-hash <model_hash> --r2 <r2_metric> --proof <proof_file>" << std::endl << std::endl;
-    std::cout << "--verify-inference --data-schema <batch_schema> --data-file <batch_file> --predictions <predictions_file> --model-hash <model_hash> --proof <proof_file>" << std::endl;  
+    std::cout << "--verify-inference --data-schema <batch_schema> --data-file <batch_file> --predictions <predictions_file> --model-hash <model_hash> [--data-handle <data_handle_file>] --proof <proof_file>" << std::endl;
+    std::cout << "Categorical batch columns are encoded with the levels of the data handle of the source dataset." << std::endl << std::endl;
+    std::cout << "Cache Dataset:" << std::endl;
+    std::cout << "--cache-dataset --data-schema <data_schema_file> --data-file <data_file> --output <cache_file>" << std::endl;
+    std::cout << "A cache file can be given as --data-file to --gen-handle and the prove and verify commands." << std::endl;
+    std::cout << "--data-file also accepts partitions, as a quoted glob (\"part-*.csv\") or @<manifest_file>" << std::endl;
+    std::cout << "listing one partition per line; partitions are read in parallel and concatenated in order." << std::endl;
+    std::cout << "So can an Arrow IPC / Feather V2 file, for builds configured with -DWITH_ARROW=ON." << std::endl << std::endl;
+    std::cout << "Generate Keys:" << std::endl;
+    std::cout << "--gen-keys [--threads <n>] [--features <n>]" << std::endl;
+    std::cout << "--features generates the provenance keys for datasets of <n> integer features, rounded up" << std::endl;
+    std::cout << "to " << M << " plus a multiple of " << column_group_width << " (model_prov_f<features>.pk/.vk); --prove-performance and" << std::endl;
+    std::cout << "--verify-performance pick them from the data schema and the data handle." << std::endl << std::endl;
+    std::cout << "Precompute Proving Keys:" << std::endl;
+    std::cout << "--precompute-key [--window <bits>] [--features <n>]" << std::endl << std::endl;
+    std::cout << "Analyze Circuits:" << std::endl;
+    std::cout << "--analyze-circuit" << std::endl << std::endl;
+    std::cout << "Benchmark Multi-Exponentiation:" << std::endl;
+    std::cout << "--bench-msm [--threads <n>]" << std::endl << std::endl;
+    std::cout << "The prove commands accept --msm <libff|pippenger> to select" << std::endl;
+    std::cout << "the multi-exponentiation engine (default libff), and" << std::endl;
+    std::cout << "--proof-format <binary|text> to select the proof encoding (default binary)." << std::endl << std::endl;
+    std::cout << "--gen-handle, --cache-dataset, --prove-performance and --gen-keys accept" << std::endl;
+    std::cout << "--hash-mode <chain|tree> to select the column hash (default chain). Tree hashes" << std::endl;
+    std::cout << "are computed in parallel and use the model_prov_tree.pk/.vk keys; --verify-performance" << std::endl;
+    std::cout << "takes the mode from the version of the data handle." << std::endl << std::endl;
+    std::cout << "--gen-handle, --cache-dataset and --prove-performance accept --hash-engine <circuit|lanes>" << std::endl;
+    std::cout << "to compute the column hashes with the witness of the circuit (default), or natively" << std::endl;
+    std::cout << "with " << mimc_lane_count << " chains in lockstep per thread." << std::endl << std::endl;
+    std::cout << "Benchmark Column Hashes:" << std::endl;
+    std::cout << "--bench-hash [--threads <n>] [--hash-mode <chain|tree>]" << std::endl << std::endl;
+    std::cout << "Result Cache:" << std::endl;
+    std::cout << "--gen-handle, --compute-hash and the prove commands accept --cache-dir <dir>" << std::endl;
+    std::cout << "[--cache-size <MB>] to reuse results across runs. Entries are keyed by the SHA-256" << std::endl;
+    std::cout << "of the inputs, the model hash, the circuit sizes and the verification key, and the" << std::endl;
+    std::cout << "least recently used ones are evicted beyond the size (default " << default_cache_mb << " MB)." << std::endl;
+    std::cout << "--prune-cache --cache-dir <dir> [--cache-size <MB>]" << std::endl;
 }
 
 void process_cmd_options(int argc, char *argv[])
@@ -1057,6 +3427,26 @@ void process_cmd_options(int argc, char *argv[])
         {"proof",               required_argument,      0,      'z'},
         {"r2",                  required_argument,      0,      'r'},
         {"predictions",         required_argument,      0,      'q'},
+        {"precompute-key",      no_argument,            0,      'k'},
+        {"gen-keys",            no_argument,            0,      'G'},
+        {"threads",             required_argument,      0,      't'},
+        {"window",              required_argument,      0,      'n'},
+        {"msm",                 required_argument,      0,      'e'},
+        {"bench-msm",           no_argument,            0,      'b'},
+        {"analyze-circuit",     no_argument,            0,      'a'},
+        {"proof-format",        required_argument,      0,      'x'},
+        {"cache-dataset",       no_argument,            0,      'y'},
+        {"export-handle",       no_argument,            0,      'X'},
+        {"appendable",          no_argument,            0,      'A'},
+        {"append-rows",         no_argument,            0,      'u'},
+        {"hash-mode",           required_argument,      0,      'H'},
+        {"hash-engine",         required_argument,      0,      'E'},
+        {"bench-hash",          no_argument,            0,      'B'},
+        {"cache-dir",           required_argument,      0,      'D'},
+        {"cache-size",          required_argument,      0,      'S'},
+        {"prune-cache",         no_argument,            0,      'P'},
+        {"handle-index",        required_argument,      0,      'I'},
+        {"features",            required_argument,      0,      'F'},
         {0, 0, 0, 0}
     };
 
@@ -1066,14 +3456,25 @@ void process_cmd_options(int argc, char *argv[])
     }
 
     // usage patterns
-    // progname --gen-handle --data-schema <schema_file> --data-file <data-file> --output <output-file>
+    // progname --gen-handle --data-schema <schema_file> --data-file <data-file> --output <output-file> [--appendable]
+    //      [--handle-index <index_file>]
     // progname --compute-hash --model-file <model_file> --output <output-file>
     // progname --prove-performance --data-schema <schema_fiel> --data-file <data-file> 
     //      --model-file <model_file> --output <output>
     // progname --prove-inference --data-schema <schema_file> --data-file <data-file> --model-file <mode_file> --output <output>
+    //      --data-handle <data_handle>
     // progname --verify-performance --data-handle <data_handle> --model-hash <model_hash> --r2 <r2> --proof <proof_file>
     // progname --verify-inference  --model-hash <model_hash> --data-schema <data_schema> --data-file <data_file> 
-    //      --predictions <predictions_file> --proof <proof_file>
+    //      --predictions <predictions_file> --proof <proof_file> [--data-handle <data_handle>]
+    // progname --cache-dataset --data-schema <schema_file> --data-file <data-file> --output <cache-file>
+    // progname --export-handle --data-handle <data_handle> [--output <yaml-file>]
+    // progname --append-rows --data-handle <data_handle> --data-schema <schema_file> --data-file <data-file> --output <output-file>
+    // progname --gen-keys [--threads <n>] [--hash-mode <chain|tree>] [--features <n>]
+    // progname --precompute-key [--window <bits>] [--features <n>]
+    // progname --bench-msm [--threads <n>]
+    // progname --bench-hash [--threads <n>] [--hash-mode <chain|tree>]
+    // progname --prune-cache --cache-dir <dir> [--cache-size <MB>]
+    // progname --analyze-circuit
     
  
     int index;
@@ -1082,7 +3483,7 @@ void process_cmd_options(int argc, char *argv[])
 
     while(iarg != -1)
     {
-        iarg = getopt_long(argc, argv, "gcpivws:f:m:h:d:o:z:r:", longopts, &index);
+        iarg = getopt_long(argc, argv, "gcpivws:f:m:h:d:o:z:r:Gt:e:bax:yXAuH:E:BD:S:PI:F:", longopts, &index);
         switch(iarg)
         {
             case 'g':
@@ -1130,6 +3531,66 @@ void process_cmd_options(int argc, char *argv[])
             case 'q':
                 options_map["predictions"] = optarg;
                 break;
+            case 'k':
+                options_map["precompute-key"]="";
+                break;
+            case 'G':
+                options_map["gen-keys"]="";
+                break;
+            case 't':
+                options_map["threads"] = optarg;
+                break;
+            case 'n':
+                options_map["window"] = optarg;
+                break;
+            case 'e':
+                options_map["msm"] = optarg;
+                break;
+            case 'b':
+                options_map["bench-msm"]="";
+                break;
+            case 'a':
+                options_map["analyze-circuit"]="";
+                break;
+            case 'x':
+                options_map["proof-format"] = optarg;
+                break;
+            case 'y':
+                options_map["cache-dataset"]="";
+                break;
+            case 'X':
+                options_map["export-handle"]="";
+                break;
+            case 'A':
+                options_map["appendable"]="";
+                break;
+            case 'u':
+                options_map["append-rows"]="";
+                break;
+            case 'H':
+                options_map["hash-mode"] = optarg;
+                break;
+            case 'E':
+                options_map["hash-engine"] = optarg;
+                break;
+            case 'B':
+                options_map["bench-hash"]="";
+                break;
+            case 'D':
+                options_map["cache-dir"] = optarg;
+                break;
+            case 'S':
+                options_map["cache-size"] = optarg;
+                break;
+            case 'P':
+                options_map["prune-cache"]="";
+                break;
+            case 'I':
+                options_map["handle-index"] = optarg;
+                break;
+            case 'F':
+                options_map["features"] = optarg;
+                break;
         }  
     }
 
@@ -1140,48 +3601,6 @@ void process_cmd_options(int argc, char *argv[])
 
 int main(int argc, char *argv[])
 {
-    const std::string test_data_dir = "/home/nitin/trustedAITestData";
-    const std::string model_schema = test_data_dir + "/model_schema.yaml";
-    const std::string model_file = test_data_dir + "/LinearModel.csv";
-    const std::string data_schema = test_data_dir + "/housing_schema.yaml";
-    const std::string data_file = test_data_dir + "/HousingData1K.dat";
-    const std::string batch_data_file = test_data_dir + "/TestData.dat";
-    const std::string batch_schema_file = test_data_dir + "/test_data_schema.yaml";
-    const std::string data_handle_file = test_data_dir + "/housingDataHandle.yaml";
-    const std::string score_schema_file = test_data_dir + "/scores_schema.yaml";
-    const std::string score_file = test_data_dir + "/TestDataPredictions.csv";
-    const std::string pkey_prov_file = test_data_dir + "/model_prov.pk";
-    const std::string vkey_prov_file = test_data_dir + "/model_prov.vk";
-    const std::string pkey_inf_file = test_data_dir + "/model_inf.pk";
-    const std::string vkey_inf_file = test_data_dir + "/model_inf.vk";
-    
     process_cmd_options(argc, argv);
-    //generate_model_inference_keys(pkey_inf_file, vkey_inf_file);
-    //generate_model_provenance_keys(pkey_prov_file, vkey_prov_file);
-    //generate_performance_proof(pkey_prov_file, data_schema, data_file, model_schema, model_file, "proof.yaml");
-    //generate_model_provenance_keys(argv[1], argv[2]);
-    //auto scores = generate_inference_proof(pkey_inf_file, batch_schema_file,
-    //    batch_data_file, model_schema, model_file;
-    //auto sd = read_schema_descriptor(model_schema);
-    //auto model = read_dataset(model_file, sd);
-    //auto model_hash = compute_model_hash(model->numeric_matrix[0]);
-    //std::cout << "Model Hash: " << model_hash << std::endl;
-    //verify_model_provenance_proof(vkey_file, argv[1], argv[2], std::atof(argv[3]), argv[4]);
-    //verify_model_provenance_proof(vkey_prov_file, data_handle_file, model_hash, 0.81, "./proof-inf.dat");
-    //std::cout << "Predictions:" << std::endl;    
-    //for(size_t i=0; i < scores.size(); ++i)
-    //    std::cout << scores[i] << std::endl;
-    
-    
-    /*
-    verify_inference_proof(vkey_inf_file,
-        batch_schema_file,
-        batch_data_file,
-        score_schema_file,
-        score_file,
-        "7c6f43fbadf17730852a74f1a4356fc5ba4b762f13555",
-        "./proof_inf.dat");
-    */
     return 0;
 }
- 
@@ -0,0 +1,46 @@
+# Checks that --append-rows gives the data handle of the concatenated
+# data: the handle of the first rows extended with the remaining ones
+# must export as the handle computed over all rows at once.
+#
+# cmake -DZKP=<trusted_ai_zkp_interface> -DSCHEMA=<schema> -DDATA=<csv>
+#       -DSPLIT=<rows of the first part> -DWORK_DIR=<dir> -P append_rows.cmake
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+# process_options reads it, data handles need no keys
+set(ENV{TRUSTED_AI_CRYPTO_CONFIG_DIR} "${WORK_DIR}")
+
+# the first part holds every categorical level, new rows may not
+# add levels
+file(STRINGS "${DATA}" lines)
+list(GET lines 0 header)
+list(REMOVE_AT lines 0)
+list(SUBLIST lines 0 ${SPLIT} head)
+list(SUBLIST lines ${SPLIT} -1 tail)
+string(REPLACE ";" "\n" head "${head}")
+string(REPLACE ";" "\n" tail "${tail}")
+file(WRITE "${WORK_DIR}/head.csv" "${header}\n${head}\n")
+file(WRITE "${WORK_DIR}/tail.csv" "${header}\n${tail}\n")
+
+function(run_zkp)
+  execute_process(COMMAND "${ZKP}" ${ARGN} RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${ZKP} ${ARGN} failed: ${result}")
+  endif()
+endfunction()
+
+run_zkp(--gen-handle --appendable --data-schema "${SCHEMA}" --data-file "${WORK_DIR}/head.csv"
+  --output "${WORK_DIR}/head.dh")
+run_zkp(--append-rows --data-handle "${WORK_DIR}/head.dh" --data-schema "${SCHEMA}"
+  --data-file "${WORK_DIR}/tail.csv" --output "${WORK_DIR}/appended.dh")
+run_zkp(--gen-handle --appendable --data-schema "${SCHEMA}" --data-file "${DATA}"
+  --output "${WORK_DIR}/full.dh")
+run_zkp(--export-handle --data-handle "${WORK_DIR}/appended.dh" --output "${WORK_DIR}/appended.yaml")
+run_zkp(--export-handle --data-handle "${WORK_DIR}/full.dh" --output "${WORK_DIR}/full.yaml")
+
+file(READ "${WORK_DIR}/appended.yaml" appended)
+file(READ "${WORK_DIR}/full.yaml" full)
+if(NOT appended STREQUAL full)
+  message(FATAL_ERROR "Appending the rows after ${SPLIT} of ${DATA} differs from its data handle, "
+    "compare ${WORK_DIR}/appended.yaml and ${WORK_DIR}/full.yaml")
+endif()